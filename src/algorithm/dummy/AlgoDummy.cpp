@@ -74,11 +74,12 @@ namespace riner {
             LOG(INFO) << "reporting: scanned " << rawIntensity << " nonces";
             device.records.reportScannedNoncesAmount(rawIntensity);
 
-            sleep_for(1s);
             device.records.reportWorkUnit(work->nonce_end - work->nonce_begin, true);
 
-            //once you notice work has expired you may abort calculation and get fresh work
-            if (work->expired()) {
+            //once you notice work has expired you may abort calculation and get fresh work.
+            //instead of polling work->expired() you can also wait for the pool to push a new job, which
+            //wakes this thread up immediately (here it just stands in for waiting on the device)
+            if (work->waitUntilExpired(1s)) {
                 continue;
             }
 
@@ -33,7 +33,11 @@ namespace riner {
 
     AlgoEthashCL::~AlgoEthashCL() {
         shutdown = true; //set atomic shutdown flag
-        //implicitly waits for gpuTasks and submitTasks to finish
+        for (auto &task : gpuTasks) {
+            task.wait();
+        }
+        //no more candidates get enqueued now
+        verifier->removeClient(*this);
     }
 
     void AlgoEthashCL::gpuTask(size_t taskIndex, cl::Device clDevice, Device &device) {
@@ -75,9 +79,9 @@ namespace riner {
                 typedef decltype(dagCache.readLock()) read_locked_cache_t;
                 unique_ptr<read_locked_cache_t> readCachePtr;
                 auto lockedCache = dagCache.immediateLock();
-                if (!lockedCache->isGenerated(work->epoch)) {
+                if (!lockedCache->isGenerated(work->data->epoch)) {
                     auto writeCache = lockedCache.upgrade();
-                    writeCache->generate(work->epoch, work->seedHash);
+                    writeCache->generate(work->data->epoch, work->data->seedHash);
                     readCachePtr = std::make_unique<read_locked_cache_t>(writeCache.downgrade());
                 }
                 else {
@@ -143,28 +147,50 @@ namespace riner {
             if (!work)
                 continue; //check shutdown and try again
 
-            if (work->epoch != dag.getEpoch()) {
+            if (work->data->epoch != dag.getEpoch()) {
                 break; //terminate task
             }
 
             auto raw_intensity = state.settings.raw_intensity;
+            const double verifyRatio = state.settings.candidate_verify_ratio;
+            EthashKernelTarget deviceTarget {};
+            const EthashKernelTarget jobTarget {work->data->jobDifficulty, work->data->jobTarget, 0};
 
             for (uint64_t nonce = 0; nonce < UINT32_MAX && !shutdown; nonce += raw_intensity) {
 
+                //follow the device's difficulty controller, but never search for a harder target than the job's
+                double deviceDifficulty = std::min(device.difficultyController->getDifficulty(), work->data->jobDifficulty);
+                if (deviceDifficulty != deviceTarget.difficulty) {
+                    deviceTarget.difficulty = deviceDifficulty;
+                    deviceTarget.target = difficultyToTargetApprox(deviceDifficulty);
+                    deviceTarget.workUnitWeight = deviceDifficulty / verifyRatio;
+                }
+
+                //every candidate has to be hashed on the cpu to find out whether it also meets the job target, so
+                //device target candidates can't be skipped individually. Instead only the fraction verifyRatio of the
+                //kernel runs searches for the device target, the others only search for (and always verify) job target
+                //candidates. The device target candidates of sampled runs stand in for the skipped ones in the DeviceRecords
+                state.verifyCredit += verifyRatio;
+                bool sampled = state.verifyCredit >= 1;
+                if (sampled) {
+                    state.verifyCredit -= 1;
+                }
+                const EthashKernelTarget &kernelTarget = sampled ? deviceTarget : jobTarget;
+                auto priority = sampled ? EthashShareVerifier::deviceTarget : EthashShareVerifier::jobTarget;
+
                 uint64_t shiftedExtraNonce = uint64_t(work->extraNonce) << 32ULL;
 
                 uint64_t nonceBegin = nonce | shiftedExtraNonce;
                 uint64_t nonceEnd = nonceBegin + raw_intensity;
 
-                auto resultNonces = runKernel(state, dag, *work, nonceBegin, nonceEnd);
+                auto resultNonces = runKernel(state, dag, *work, kernelTarget, nonceBegin, nonceEnd);
 
+                auto foundTime = clock::now();
                 for (uint64_t resultNonce : resultNonces) {
-                    tasks.addTask([=, &device] () {
-                        SetThreadNameStream{} << "EthashCL submit share";
-                        submitShare(work, resultNonce, device);
-                    });
+                    verifier->enqueue(*this, {work, resultNonce, kernelTarget, &device, foundTime}, priority);
                 }
                 device.records.reportScannedNoncesAmount(raw_intensity);
+                device.difficultyController->reportScannedNonces(raw_intensity);
 
                 if (work->expired()) {
                     VLOG(0) << "aborting kernel loop because work has expired on " << getThreadName();
@@ -175,28 +201,43 @@ namespace riner {
         VLOG(5) << "gpuSubTask done";
     }
 
-    void AlgoEthashCL::submitShare(std::shared_ptr<const WorkEthash> work, uint64_t nonce, Device &device) {
-
-        auto result = work->makeWorkSolution<WorkSolutionEthash>();
-
-        //calculate proof of work hash from nonce and dag-caches
-        auto hashes = dagCache.readLock()->getHash(work->header, nonce);
+    void AlgoEthashCL::verifyBatch(std::vector<EthashShareVerifier::Candidate> &batch) {
+        RNR_EXPECTS(!batch.empty());
+        const WorkEthash::JobData &job = *batch.front().work->data; //same for the whole batch
+
+        //calculate proof of work hashes from nonces and dag-caches, locking the cache only once per batch
+        std::vector<DagCacheContainer::HashResult> hashes;
+        hashes.reserve(batch.size());
+        {
+            auto readCache = dagCache.readLock();
+            for (auto &candidate : batch) {
+                hashes.push_back(readCache->getHash(job.header, candidate.nonce));
+            }
+        }
 
-        result->nonce = nonce;
-        result->header = work->header;
-        result->mixHash = hashes.mixHash;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            auto &candidate = batch[i];
 
-        if (lessThanLittleEndian(hashes.proofOfWorkHash, work->jobTarget))
-            pool.submitSolution(std::move(result));
+            if (lessThanLittleEndian(hashes[i].proofOfWorkHash, job.jobTarget)) {
+                auto result = candidate.work->makeWorkSolution<WorkSolutionEthash>();
+                result->nonce = candidate.nonce;
+                result->header = job.header;
+                result->mixHash = hashes[i].mixHash;
+                pool.submitSolution(std::move(result));
+            }
 
-        bool isValidSolution = lessThanLittleEndian(hashes.proofOfWorkHash, work->deviceTarget);
-        device.records.reportWorkUnit(work->deviceDifficulty, isValidSolution);
-        if (!isValidSolution) {
-            LOG(INFO) << "discarding invalid solution nonce: 0x" << HexString(toBytesWithBigEndian(nonce)).str();
+            bool isValidSolution = lessThanLittleEndian(hashes[i].proofOfWorkHash, candidate.target.target);
+            if (candidate.target.workUnitWeight > 0) {
+                //extrapolated to the kernel runs that didn't search for the device target (see gpuSubTask)
+                candidate.device->records.reportWorkUnit(candidate.target.workUnitWeight, isValidSolution);
+            }
+            if (!isValidSolution) {
+                LOG(INFO) << "discarding invalid solution nonce: 0x" << HexString(toBytesWithBigEndian(candidate.nonce)).str();
+            }
         }
     }
 
-    std::vector<uint64_t> AlgoEthashCL::runKernel(PerGpuSubTask &state, DagFile &dag, const WorkEthash &work,
+    std::vector<uint64_t> AlgoEthashCL::runKernel(PerGpuSubTask &state, DagFile &dag, const WorkEthash &work, const EthashKernelTarget &kernelTarget,
                                                           uint64_t nonceBegin, uint64_t nonceEnd) {
         cl_int err = 0;
         std::vector<uint64_t> results;
@@ -204,10 +245,10 @@ namespace riner {
         cl_uint size = dag.getSize();
         cl_uint isolate = UINT32_MAX;
         uint64_t target64 = 0;
-        RNR_EXPECTS(work.deviceTarget.size() - 24 == sizeof(target64));
-        memcpy(&target64, work.deviceTarget.data() + 24, work.deviceTarget.size() - 24);
+        RNR_EXPECTS(kernelTarget.target.size() - 24 == sizeof(target64));
+        memcpy(&target64, kernelTarget.target.data() + 24, kernelTarget.target.size() - 24);
 
-        err = state.cmdQueue.enqueueWriteBuffer(state.header, CL_FALSE, 0, work.header.size(), work.header.data());
+        err = state.cmdQueue.enqueueWriteBuffer(state.header, CL_FALSE, 0, work.data->header.size(), work.data->header.data());
         RNR_RETURN_ON_CL_ERR(err, "error when writing work header to cl buffer", results);
 
         cl_uint argI = 0;
@@ -8,8 +8,8 @@
 #include <src/pool/Pool.h>
 #include <src/algorithm/ethash/DagCache.h>
 #include <src/algorithm/ethash/DagFile.h>
+#include <src/algorithm/ethash/EthashShareVerifier.h>
 #include <src/util/LockUtils.h>
-#include <src/util/TaskExecutorPool.h>
 #include <src/compute/opencl/CLProgramLoader.h>
 
 #include <mutex>
@@ -19,7 +19,7 @@ namespace riner {
     /**
      * AlgoImpl for powType "ethash" with compute Api "OpenCL"
      */
-    class AlgoEthashCL : public Algorithm {
+    class AlgoEthashCL : public Algorithm, private EthashShareVerifier::Client {
 
         UpgradeableLockGuarded<DagCacheContainer> dagCache;
         Pool &pool;
@@ -38,6 +38,7 @@ namespace riner {
             cl::Buffer header;
             cl::Buffer clOutputBuffer;
             AlgoSettings settings;
+            double verifyCredit = 0; //decides which kernel runs search for the device target, see gpuSubTask
 
             typedef uint32_t buffer_entry_t;
             constexpr static size_t bufferCount = 0x100;
@@ -46,8 +47,8 @@ namespace riner {
             std::vector<buffer_entry_t> outputBuffer = std::vector<buffer_entry_t>(bufferCount, 0); //this is where clOutputBuffer gets read into
         };
 
-        //used to execute share submission tasks. It's safe to not track the futures returned by addTask() due to the lifetime of tasks
-        TaskExecutorPool tasks {std::min(std::thread::hardware_concurrency(), 2U)};
+        //verifies and submits the candidates found by the gpus, shared with all other AlgoEthashCL instances
+        std::shared_ptr<EthashShareVerifier> verifier = EthashShareVerifier::getShared();
 
         std::vector<std::future<void>> gpuTasks; //one task per gpu
 
@@ -57,11 +58,11 @@ namespace riner {
         //gets called numGpuSubTasks times from each gpuTask
         void gpuSubTask(size_t subTaskIndex, PerPlatform &, cl::Device &, DagFile &dag, Device &deviceSettings);
 
-        //gets called by gpuSubTask for each nonce found
-        void submitShare(std::shared_ptr<const WorkEthash> work, uint64_t nonce, Device &device);
+        //gets called by the verifier for the nonces found by the gpus, submits the actual shares
+        void verifyBatch(std::vector<EthashShareVerifier::Candidate> &batch) override;
 
         //returns possible solution nonces
-        std::vector<uint64_t> runKernel(PerGpuSubTask &, DagFile &dag, const WorkEthash &,
+        std::vector<uint64_t> runKernel(PerGpuSubTask &, DagFile &dag, const WorkEthash &, const EthashKernelTarget &,
                 uint64_t nonceBegin, uint64_t nonceEnd);
 
     public:
@@ -0,0 +1,146 @@
+//
+//
+
+#include "EthashShareVerifier.h"
+#include <src/common/Assert.h>
+#include <src/util/Logging.h>
+#include <algorithm>
+
+namespace riner {
+
+    namespace {
+        std::mutex sharedMutex;
+        std::weak_ptr<EthashShareVerifier> sharedVerifier;
+    }
+
+    std::shared_ptr<EthashShareVerifier> EthashShareVerifier::getShared() {
+        std::lock_guard<std::mutex> lock(sharedMutex);
+        auto verifier = sharedVerifier.lock();
+        if (!verifier) {
+            size_t threadCount = std::min(std::thread::hardware_concurrency(), 2U);
+            verifier = std::make_shared<EthashShareVerifier>(threadCount);
+            sharedVerifier = verifier;
+        }
+        return verifier;
+    }
+
+    EthashShareVerifier::Stats EthashShareVerifier::getSharedStats() {
+        std::shared_ptr<EthashShareVerifier> verifier;
+        {
+            std::lock_guard<std::mutex> lock(sharedMutex);
+            verifier = sharedVerifier.lock();
+        }
+        return verifier ? verifier->getStats() : Stats{};
+    }
+
+    EthashShareVerifier::EthashShareVerifier(size_t threadCount) {
+        for (size_t i = 0; i < std::max(threadCount, size_t(1)); ++i) {
+            _threads.push_back(std::async(std::launch::async, [this, i] () {
+                SetThreadNameStream{} << "ethash verifier#" << i;
+                verifyLoop();
+            }));
+        }
+    }
+
+    EthashShareVerifier::~EthashShareVerifier() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _shutdown = true;
+        }
+        _cv.notify_all();
+        //_threads' destructors wait for the threads
+    }
+
+    void EthashShareVerifier::enqueue(Client &client, Candidate candidate, Priority priority) {
+        RNR_EXPECTS(priority < priorityCount);
+        const WorkEthash::JobData *job = candidate.work->data.get();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto &queue = _pending[priority];
+
+            auto it = std::find_if(queue.begin(), queue.end(), [&] (const Batch &batch) {
+                return batch.client == &client && batch.job == job;
+            });
+            if (it != queue.end()) {
+                it->candidates.push_back(std::move(candidate));
+            }
+            else {
+                queue.push_back(Batch{&client, job, {}});
+                queue.back().candidates.push_back(std::move(candidate));
+            }
+            ++_stats.queueDepth[priority];
+        }
+        _cv.notify_one();
+    }
+
+    void EthashShareVerifier::removeClient(Client &client) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        size_t dropped = 0;
+        for (size_t p = 0; p < priorityCount; ++p) {
+            auto &queue = _pending[p];
+            for (auto it = queue.begin(); it != queue.end();) {
+                if (it->client == &client) {
+                    dropped += it->candidates.size();
+                    _stats.queueDepth[p] -= it->candidates.size();
+                    it = queue.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+        if (dropped) {
+            VLOG(0) << "dropped " << dropped << " unverified share candidates on shutdown";
+        }
+
+        _batchDone.wait(lock, [&] {
+            return std::find(_running.begin(), _running.end(), &client) == _running.end();
+        });
+    }
+
+    EthashShareVerifier::Stats EthashShareVerifier::getStats() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
+    void EthashShareVerifier::verifyLoop() {
+        const double latencySmoothing = 0.1; //weight of the latest sample in avgLatencySecs
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            _cv.wait(lock, [&] {
+                return _shutdown || std::any_of(_pending.begin(), _pending.end(), [] (auto &q) {return !q.empty();});
+            });
+            if (_shutdown) {
+                return;
+            }
+
+            //highest priority first, batches of the same priority in fifo order
+            size_t priority = 0;
+            while (_pending[priority].empty()) {
+                ++priority;
+            }
+            Batch batch = std::move(_pending[priority].front());
+            _pending[priority].pop_front();
+            _stats.queueDepth[priority] -= batch.candidates.size();
+            _running.push_back(batch.client);
+
+            lock.unlock();
+            batch.client->verifyBatch(batch.candidates);
+            auto now = clock::now();
+            lock.lock();
+
+            _running.erase(std::find(_running.begin(), _running.end(), batch.client));
+            ++_stats.batches;
+            for (auto &candidate : batch.candidates) {
+                double latency = std::chrono::duration<double>(now - candidate.foundTime).count();
+                double &avg = _stats.avgLatencySecs[priority];
+                avg = _stats.verified[priority] == 0 ? latency : (1 - latencySmoothing) * avg + latencySmoothing * latency;
+                _stats.maxLatencySecs[priority] = std::max(_stats.maxLatencySecs[priority], latency);
+                ++_stats.verified[priority];
+            }
+            _batchDone.notify_all();
+        }
+    }
+
+}
@@ -0,0 +1,128 @@
+//
+//
+
+#pragma once
+
+#include <src/pool/WorkEthash.h>
+#include <src/common/Chrono.h>
+#include <src/util/Bytes.h>
+#include <src/util/Copy.h>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <array>
+
+namespace riner {
+
+    struct Device;
+
+    /**
+     * target that a gpu kernel searched for. Either the per-device target, which is easier than the job target
+     * (see DifficultyController), or the job target itself (see candidate_verify_ratio)
+     */
+    struct EthashKernelTarget {
+        double difficulty;
+        Bytes<32> target;
+        double workUnitWeight; //difficulty that a verified candidate is reported with to the DeviceRecords, 0 to not report it
+    };
+
+    /**
+     * @brief process-wide service that verifies the share candidates (nonces) found by the gpus of all ethash AlgoImpls
+     * on the cpu.
+     * Candidates are grouped into batches of the same job (and therefore the same header and epoch), so that a
+     * Client can verify a whole batch under a single lock of its dag cache.
+     * Candidates of kernel runs that searched for the job target are real shares and always verified before the
+     * candidates that only meet the device target, so a noisy device can't delay the submission of shares.
+     */
+    class EthashShareVerifier {
+    public:
+        enum Priority : size_t {
+            jobTarget = 0, //candidate of a kernel run that searched for the job target, most likely a share
+            deviceTarget,  //candidate of a kernel run that searched for the (easier) device target
+            priorityCount
+        };
+
+        struct Candidate {
+            std::shared_ptr<const WorkEthash> work;
+            uint64_t nonce;
+            EthashKernelTarget target;
+            Device *device;
+            clock::time_point foundTime;
+        };
+
+        /**
+         * implemented by the AlgoImpls, which own the dag caches and the pool to submit to
+         */
+        class Client {
+        public:
+            /**
+             * called on one of the verifier's threads
+             * @param batch candidates which all belong to the same job (same `work->data`)
+             */
+            virtual void verifyBatch(std::vector<Candidate> &batch) = 0;
+
+        protected:
+            ~Client() = default;
+        };
+
+        struct Stats {
+            std::array<size_t, priorityCount> queueDepth {}; //candidates waiting for verification
+            std::array<uint64_t, priorityCount> verified {}; //candidates verified so far
+            std::array<double, priorityCount> avgLatencySecs {}; //smoothed time from finding to verifying a candidate
+            std::array<double, priorityCount> maxLatencySecs {};
+            uint64_t batches = 0; //verifyBatch calls so far
+        };
+
+        /**
+         * @return the process-wide verifier, which is created on first use and lives as long as one of the returned
+         * shared_ptrs
+         */
+        static std::shared_ptr<EthashShareVerifier> getShared();
+
+        /**
+         * @return stats of the process-wide verifier, or all zeros if there is none at the moment
+         */
+        static Stats getSharedStats();
+
+        explicit EthashShareVerifier(size_t threadCount);
+        ~EthashShareVerifier();
+
+        DELETE_COPY_AND_MOVE(EthashShareVerifier);
+
+        /**
+         * queue a candidate for verification by client.verifyBatch. thread-safe
+         */
+        void enqueue(Client &client, Candidate candidate, Priority priority);
+
+        /**
+         * drops the client's pending candidates and waits until the client's batches that are currently being verified
+         * are done. Must be called before a Client is destroyed, after it stopped calling enqueue
+         */
+        void removeClient(Client &client);
+
+        Stats getStats() const;
+
+    private:
+        struct Batch {
+            Client *client;
+            const WorkEthash::JobData *job; //all candidates of the batch share the same job
+            std::vector<Candidate> candidates;
+        };
+
+        mutable std::mutex _mutex;
+        std::condition_variable _cv; //notified on new candidates and shutdown
+        std::condition_variable _batchDone; //for removeClient
+        std::array<std::deque<Batch>, priorityCount> _pending;
+        std::vector<Client *> _running; //one entry per batch that is currently being verified
+        bool _shutdown = false;
+        Stats _stats;
+
+        std::vector<std::future<void>> _threads;
+
+        void verifyLoop();
+    };
+
+}
@@ -0,0 +1,128 @@
+
+#include <src/algorithm/ethash/EthashShareVerifier.h>
+
+#include <gtest/gtest.h>
+#include <future>
+#include <thread>
+
+namespace riner {
+namespace {
+
+using Candidate = EthashShareVerifier::Candidate;
+
+/**
+ * records the batches it is asked to verify. The first batch blocks until release() is called, so that the test can
+ * fill the queue while the verifier thread is busy
+ */
+class RecordingClient : public EthashShareVerifier::Client {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool released = false;
+    bool busy = false;
+
+public:
+    std::vector<std::vector<uint64_t>> batches; //nonces per verified batch
+
+    void verifyBatch(std::vector<Candidate> &batch) override {
+        std::unique_lock<std::mutex> lock(mutex);
+        busy = true;
+        cv.notify_all();
+        cv.wait(lock, [&] {return released;});
+
+        batches.emplace_back();
+        for (auto &candidate : batch) {
+            batches.back().push_back(candidate.nonce);
+        }
+    }
+
+    void waitUntilBusy() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] {return busy;});
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+        cv.notify_all();
+    }
+};
+
+std::shared_ptr<const WorkEthash> makeWork() {
+    return std::make_shared<WorkEthash>(std::make_shared<WorkEthash::JobData>());
+}
+
+Candidate makeCandidate(const std::shared_ptr<const WorkEthash> &work, uint64_t nonce) {
+    return Candidate{work, nonce, EthashKernelTarget{}, nullptr, clock::now()};
+}
+
+TEST(EthashShareVerifier, RemoveClientDropsPendingCandidates) {
+    EthashShareVerifier verifier {1};
+    RecordingClient client;
+    auto jobA = makeWork();
+    auto jobB = makeWork();
+
+    verifier.enqueue(client, makeCandidate(jobA, 0), EthashShareVerifier::deviceTarget);
+    client.waitUntilBusy();
+
+    //queued while the only verifier thread is busy with nonce 0
+    verifier.enqueue(client, makeCandidate(jobA, 1), EthashShareVerifier::deviceTarget);
+    verifier.enqueue(client, makeCandidate(jobB, 2), EthashShareVerifier::deviceTarget);
+    verifier.enqueue(client, makeCandidate(jobA, 3), EthashShareVerifier::deviceTarget);
+    verifier.enqueue(client, makeCandidate(jobB, 4), EthashShareVerifier::jobTarget);
+
+    auto stats = verifier.getStats();
+    EXPECT_EQ(stats.queueDepth[EthashShareVerifier::deviceTarget], 3);
+    EXPECT_EQ(stats.queueDepth[EthashShareVerifier::jobTarget], 1);
+
+    //remove the client while the verifier thread is still held in the first batch, so that it can't pick up any of
+    //the queued candidates. the queue is only drained by removeClient then, which is how we know it has started
+    auto removal = std::async(std::launch::async, [&] {
+        verifier.removeClient(client); //drops the queued candidates, then waits for the running batch
+    });
+    for (int i = 0; i < 500 && verifier.getStats().queueDepth != decltype(stats.queueDepth){}; ++i) {
+        std::this_thread::sleep_for(milliseconds(2));
+    }
+    EXPECT_EQ(removal.wait_for(milliseconds(0)), std::future_status::timeout); //still waiting for the running batch
+
+    client.release();
+    removal.get();
+
+    std::vector<std::vector<uint64_t>> expected {{0}};
+    EXPECT_EQ(client.batches, expected);
+    EXPECT_EQ(verifier.getStats().queueDepth[EthashShareVerifier::deviceTarget], 0);
+}
+
+TEST(EthashShareVerifier, VerifiesEverythingInPriorityOrder) {
+    EthashShareVerifier verifier {1};
+    RecordingClient client;
+    auto jobA = makeWork();
+    auto jobB = makeWork();
+
+    verifier.enqueue(client, makeCandidate(jobA, 0), EthashShareVerifier::deviceTarget);
+    client.waitUntilBusy();
+
+    verifier.enqueue(client, makeCandidate(jobA, 1), EthashShareVerifier::deviceTarget);
+    verifier.enqueue(client, makeCandidate(jobB, 2), EthashShareVerifier::deviceTarget);
+    verifier.enqueue(client, makeCandidate(jobA, 3), EthashShareVerifier::deviceTarget);
+    verifier.enqueue(client, makeCandidate(jobB, 4), EthashShareVerifier::jobTarget);
+    client.release();
+
+    for (int i = 0; i < 100 && verifier.getStats().batches < 4; ++i) {
+        std::this_thread::sleep_for(milliseconds(10));
+    }
+    verifier.removeClient(client);
+
+    //the share candidate (4) overtakes the device target candidates, which are batched per job
+    std::vector<std::vector<uint64_t>> expected {{0}, {4}, {1, 3}, {2}};
+    EXPECT_EQ(client.batches, expected);
+
+    auto stats = verifier.getStats();
+    EXPECT_EQ(stats.batches, 4);
+    EXPECT_EQ(stats.verified[EthashShareVerifier::jobTarget], 1);
+    EXPECT_EQ(stats.verified[EthashShareVerifier::deviceTarget], 4);
+    EXPECT_EQ(stats.queueDepth[EthashShareVerifier::deviceTarget], 0);
+    EXPECT_GT(stats.maxLatencySecs[EthashShareVerifier::deviceTarget], 0);
+}
+
+} // namespace
+} // riner
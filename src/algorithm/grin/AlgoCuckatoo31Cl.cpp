@@ -41,7 +41,7 @@ AlgoCuckatoo31Cl::~AlgoCuckatoo31Cl() {
 
 /* static */SiphashKeys AlgoCuckatoo31Cl::calculateKeys(const WorkCuckatoo31& header) {
     SiphashKeys keys;
-    std::vector<uint8_t> h = header.prePow;
+    std::vector<uint8_t> h = header.data->prePow;
     uint64_t nonce = header.nonce;
     VLOG(0) << "nonce = " << nonce;
     size_t len = h.size();
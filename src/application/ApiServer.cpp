@@ -2,11 +2,13 @@
 #include "ApiServer.h"
 #include <numeric>
 #include <src/algorithm/Algorithm.h>
+#include <src/algorithm/ethash/EthashShareVerifier.h>
 #include <src/common/Assert.h>
 #include <src/common/Chrono.h>
 #include <src/application/Application.h>
 #include <src/pool/PoolSwitcher.h>
 #include <src/statistics/PoolRecords.h>
+#include <src/util/RecyclingPool.h>
 
 namespace riner {
     using namespace jrpc;
@@ -77,7 +79,9 @@ namespace riner {
         return {
             {"accepted", jsonSerialize(data.acceptedShares, time)},
             {"rejected", jsonSerialize(data.rejectedShares, time)},
-            {"duplicate", jsonSerialize(data.duplicateShares, time)}
+            {"duplicate", jsonSerialize(data.duplicateShares, time)},
+            {"stale", jsonSerialize(data.staleShares, time)},
+            {"orphaned", jsonSerialize(data.orphanedShares, time)}
         };
     }
 
@@ -123,6 +127,10 @@ namespace riner {
                             {"workUnits", jsonSerialize(data.validWorkUnits, now)},
                             {"hwErrors", jsonSerialize(data.invalidWorkUnits, now)}
                     };
+                    if (d.difficultyController->isInUse()) {
+                        j["deviceDifficulty"] = d.difficultyController->getDifficulty();
+                        j["candidatesPerMinute"] = d.difficultyController->getCandidatesPerMinute();
+                    }
                     if (d.api) {
                         nl::json hw = nl::json::object();
                         if (auto temp = d.api->getTemperature()) {
@@ -162,6 +170,41 @@ namespace riner {
             return result;
         });
 
+        io->addMethod("getAllocatorStats", [] () {
+
+            nl::json result = nl::json::array();
+
+            for (auto &stats : RecyclingPoolBase::getAllStats()) {
+                result.push_back({
+                        {"name", stats.name},
+                        {"objectSize", stats.objectSize},
+                        {"allocations", stats.allocations},
+                        {"heapAllocations", stats.heapAllocations},
+                        {"heapFrees", stats.heapFrees},
+                        {"sharedFreeListSize", stats.sharedFreeListSize}
+                });
+            }
+            return result;
+        });
+
+        io->addMethod("getShareVerifierStats", [&] () {
+
+            auto stats = EthashShareVerifier::getSharedStats();
+            nl::json result = {{"batches", stats.batches}};
+
+            const char *names[] = {"jobTarget", "deviceTarget"};
+            static_assert(sizeof(names) / sizeof(*names) == EthashShareVerifier::priorityCount, "name every priority");
+            for (size_t p = 0; p < EthashShareVerifier::priorityCount; ++p) {
+                result[names[p]] = {
+                        {"queueDepth", stats.queueDepth[p]},
+                        {"verified", stats.verified[p]},
+                        {"avgLatencyMs", stats.avgLatencySecs[p] * 1000},
+                        {"maxLatencyMs", stats.maxLatencySecs[p] * 1000}
+                };
+            }
+            return result;
+        });
+
         io->addMethod("getPoolStats", [&] () {
 
             nl::json result;
@@ -176,20 +219,27 @@ namespace riner {
                 nl::json switcheri;
 
                 const auto &pools = poolSwitcher->getPoolsData();
+                const auto &data = poolSwitcher->readRecords();
 
                 for (auto &pool : pools) {
-                    const auto &data = pool->readRecords();
+                    const auto &poolData = pool->readRecords();
+                    auto rtt = pool->getSmoothedRoundTrip();
                     nl::json poolj = {
                             {"url", pool->constructionArgs.host + ":" + std::to_string(pool->constructionArgs.port)},
-                            {"shares", jsonSerialize(data)},
+                            {"shares", jsonSerialize(poolData)},
                             {"connected", pool->isConnected()},
-                            {"connectionSec", std::chrono::duration<double>(data.connectionDuration()).count()}
+                            {"connectionSec", std::chrono::duration<double>(poolData.connectionDuration()).count()},
+                            {"splitWeight", poolSwitcher->getSplitWeight(*pool)},
+                            {"effectiveShare", poolData.effectiveShareOf(data)},
+                            {"rejectedRatio", poolData.rejectedRatio()}
                     };
+                    if (rtt) {
+                        poolj["rttMs"] = std::chrono::duration<double, std::milli>(*rtt).count();
+                    }
 
                     switcheri.push_back(poolj);
                 }
 
-                const auto &data = poolSwitcher->readRecords();
                 result[powType] = {
                         {"pools", switcheri},
                         {"shares", jsonSerialize(data)}
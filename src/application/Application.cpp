@@ -7,6 +7,7 @@
 #include <src/util/Logging.h>
 #include <src/util/ConfigUtils.h>
 #include <src/application/ApiServer.h>
+#include <src/network/IORuntime.h>
 #include <thread>
 
 namespace riner {
@@ -18,6 +19,10 @@ namespace riner {
         //init devicesInUse
         devicesInUse.lock()->resize(compute.getAllDeviceIds().size());
 
+        //must happen before any BaseIO is constructed
+        IORuntime::setSharedThreadCount(config.global_settings().io_threads());
+        VLOG(1) << "network io backend: " << IORuntime::backendName();
+
         auto api_port = config.global_settings().api_port();
         apiServer = make_unique<ApiServer>(api_port, *this);
 
@@ -69,6 +74,13 @@ namespace riner {
             auto &poolSwitcher = lockedPoolSwitchers->at(powType);
             RNR_ENSURES(lockedPoolSwitchers->count(powType));
 
+            if (config.global_settings().has_standby_pools()) {
+                poolSwitcher->setStandbyPoolCount(config.global_settings().standby_pools());
+            }
+            if (config.global_settings().prefer_low_latency_pools()) {
+                poolSwitcher->setLatencyAwareSelection(true);
+            }
+
             for (auto &configPool : configPools) {
                 auto &p = configPool.get();
 
@@ -83,6 +95,15 @@ namespace riner {
                 }
                 PoolConstructionArgs args {p.host(), port, p.username(), p.password(), std::move(sslDesc)};
 
+                switch (p.stale_share_policy()) {
+                    case Config::Pool::SUBMIT_STALE:  args.staleSharePolicy = StaleSharePolicy::submitStale;  break;
+                    case Config::Pool::DROP_CLEANED:  args.staleSharePolicy = StaleSharePolicy::dropCleaned;  break;
+                    case Config::Pool::DROP_OUTDATED: args.staleSharePolicy = StaleSharePolicy::dropOutdated; break;
+                }
+                if (p.has_record_session_file()) {
+                    args.recordSessionFile = p.record_session_file();
+                }
+
                 const std::string poolImplName = registry.poolImplForProtocolAndPowType(p.protocol(), powType);
                 if (poolImplName.empty()) {
                     LOG(ERROR) << "no pool implementation available for powType '"
@@ -93,7 +114,7 @@ namespace riner {
 
                 LOG(INFO) << "launching pool '" << poolImplName << "' to connect to " << p.host() << " on port " << p.port();
 
-                poolSwitcher->tryAddPool(args, poolImplName.c_str(), registry);
+                poolSwitcher->tryAddPool(args, poolImplName.c_str(), registry, p.split_weight());
             }
 
             if (poolSwitcher->poolCount() == 0) {
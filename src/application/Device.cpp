@@ -7,6 +7,7 @@ namespace riner {
     : id(_id)
     , settings(_settings)
     , deviceIndex(_deviceIndex)
+    , difficultyController(std::make_unique<DifficultyController>(_settings.candidates_per_minute))
     , api(GpuApi::tryCreate(GpuApiConstructionArgs{_id, _settings.gpuSettings})) {
     }
 
@@ -3,6 +3,7 @@
 #include <src/compute/DeviceId.h>
 #include <src/gpu_api/GpuApi.h>
 #include <src/statistics/DeviceRecords.h>
+#include <src/util/DifficultyController.h>
 #include <src/util/Copy.h>
 #include "src/config/Config.h"
 
@@ -32,6 +33,12 @@ namespace riner {
          * report per-device hashrate etc, via this object from within an `AlgoImpl`
          */
         DeviceRecords records;
+
+        /**
+         * adapts the device target difficulty to the device's hashrate, for `AlgoImpl`s that verify the device's
+         * candidate solutions on the cpu (e.g. ethash's deviceTarget). Never nullptr
+         */
+        std::unique_ptr<DifficultyController> difficultyController;
         
         /**
          * interact with an optional GpuApi. May be nullptr if no GpuApi could be initialized.
@@ -88,6 +88,7 @@ namespace riner {
          */
         struct EntryAlgo {
             std::string powType;
+            PowTypeId powTypeId; //powTypeIdFromString(powType)
             std::function<unique_ptr<Algorithm>(AlgoConstructionArgs &&)> makeFunc;
         };
 
@@ -96,6 +97,7 @@ namespace riner {
          */
         struct EntryPool {
             std::string powType;
+            PowTypeId powTypeId; //powTypeIdFromString(powType)
             std::string protocolType;
             std::string protocolTypeAlias;
             std::function<shared_ptr<Pool>(PoolConstructionArgs &&)> makeFunc;
@@ -112,6 +114,12 @@ namespace riner {
         std::map<std::string, EntryPool> _poolWithName;
         std::map<std::string, EntryGpuApi> _gpuApiWithName;
 
+        /**
+         * makes sure that powType's PowTypeId does not collide with the id of a different, already registered PowType
+         * @return powTypeIdFromString(powType)
+         */
+        PowTypeId checkedPowTypeId(const std::string &powType) const;
+
         /**
          * Register an AlgoImpl type and generate a factory function for it.
          * @param AlgoT the type of the Algorithm subclass (e.g. AlgoEthashCL)
@@ -125,6 +133,7 @@ namespace riner {
 
             _algoWithName[algoImplName] = {
                     powType,
+                    checkedPowTypeId(powType),
                     [] (AlgoConstructionArgs &&args) -> unique_ptr<Algorithm> {
                         return make_unique<AlgoT>(std::move(args));
                     }
@@ -144,6 +153,7 @@ namespace riner {
 
             _poolWithName[poolImplName] = {
                     powType,
+                    checkedPowTypeId(powType),
                     protocolType,
                     protocolTypeAlias,
                     [=] (PoolConstructionArgs &&args) -> shared_ptr<Pool> {
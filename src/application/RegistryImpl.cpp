@@ -96,10 +96,12 @@ namespace riner {
     }
 
     std::string Registry::poolImplForProtocolAndPowType(const std::string &protocolType, const std::string &powType) const {
+        const PowTypeId powTypeId = powTypeIdFromString(powType); //ids are case insensitive
+
         for (auto &pair : _poolWithName) {
             const std::string &poolImplName = pair.first;
             const EntryPool &e = pair.second;
-            bool samePow = toLower(e.powType) == toLower(powType);
+            bool samePow = e.powTypeId == powTypeId;
 
             bool sameProto = protocolType.empty(); // pick first protocol if powType is empty
             if (sameProto && samePow) {
@@ -115,4 +117,19 @@ namespace riner {
         }
         return "";
     }
+
+    PowTypeId Registry::checkedPowTypeId(const std::string &powType) const {
+        const PowTypeId id = powTypeIdFromString(powType);
+
+        auto collides = [&] (const std::string &otherPowType, PowTypeId otherId) {
+            return otherId == id && toLower(otherPowType) != toLower(powType);
+        };
+        for (auto &pair : _algoWithName) {
+            RNR_EXPECTS(!collides(pair.second.powType, pair.second.powTypeId));
+        }
+        for (auto &pair : _poolWithName) {
+            RNR_EXPECTS(!collides(pair.second.powType, pair.second.powTypeId));
+        }
+        return id;
+    }
 }
@@ -62,6 +62,8 @@ if (!obj. has_##member () ) { \
                 default_value(as, num_threads, 1);
                 default_value(as, work_size, 128);
                 default_value(as, raw_intensity, 1048576);
+                default_value(as, candidates_per_minute, 30);
+                default_value(as, candidate_verify_ratio, 1.0);
             }
         }
 
@@ -117,6 +119,8 @@ if (!(_min <= x && x <= _max)) { \
                     }
 
                     check_between(as.raw_intensity(), 1, u32_max); //TODO: values
+                    check_between(as.candidates_per_minute(), 1, 60000);
+                    check_between(as.candidate_verify_ratio(), 0.001, 1.0);
 
                 }
             }
@@ -193,6 +197,8 @@ if (!(_min <= x && x <= _max)) { \
         set_if_has(num_threads, num_threads);
         set_if_has(work_size, work_size);
         set_if_has(raw_intensity, raw_intensity);
+        set_if_has(candidates_per_minute, candidates_per_minute);
+        set_if_has(candidate_verify_ratio, candidate_verify_ratio);
 
 #undef set_if_has
     }
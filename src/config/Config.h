@@ -69,7 +69,10 @@ namespace riner {
         uint32_t
                 num_threads = 0,
                 work_size = 0,
-                raw_intensity = 0;
+                raw_intensity = 0,
+                candidates_per_minute = 30;
+
+        double candidate_verify_ratio = 1; //fraction of device target candidates that get verified, see config.proto
     };
 
     /**
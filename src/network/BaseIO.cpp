@@ -4,6 +4,8 @@
 #include <src/common/Assert.h>
 #include <src/util/AsioErrorUtil.h>
 #include "BaseIO.h"
+#include <algorithm>
+#include <deque>
 
 #ifdef HAS_OPENSSL
 #include <asio/ssl.hpp>
@@ -16,12 +18,28 @@ namespace riner {
     //TODO: remove IOConnection base class. The Socket abstraction now does what was originally thought to be the responsibility of this
     //class hierarchy.
     struct Connection : public IOConnection, public std::enable_shared_from_this<Connection> {
+        BaseIO &_io; //for wrapping handlers, see BaseIO::wrap
         IOOnDisconnectedFunc &_onDisconnected;
         BaseIO::OnReceiveValueFunc &_onRecv;
+        BaseIO::AtomicIOStats &_stats;
         unique_ptr<Socket> _socket;
-        asio::streambuf _incoming;
         uint64_t _baseIOUid = 0;
 
+        //outgoing messages are queued while a write is in progress, and then sent together with a single gather write.
+        //this also guarantees that the messages of concurrent writes can't interleave on the stream
+        std::deque<std::string> _writeQueue;
+        std::vector<std::string> _writing; //messages of the write in progress, must stay alive until it completes
+        bool _writeInProgress = false;
+
+        //received bytes, [_readBegin, _readEnd) are not delivered yet. lines are delivered straight from this buffer,
+        //the remaining partial line is moved to the front before the next socket read
+        std::vector<char> _readBuffer = std::vector<char>(4096);
+        size_t _readBegin = 0;
+        size_t _readEnd = 0;
+        bool _dispatchingLines = false; //whether _onRecv is currently being called from deliverLinesOrRead()
+        bool _readRequested = false; //whether asyncRead() was called during the current _onRecv call
+        bool _socketReadPending = false;
+
         static size_t generateConnectionUid() {
             static std::atomic<uint64_t> nextUid = {1};
             return nextUid++;
@@ -29,10 +47,16 @@ namespace riner {
 
         uint64_t _connectionUid = generateConnectionUid();
 
-        Connection(decltype(_onDisconnected) &onDisconnected, decltype(_onRecv) &onRecv, unique_ptr<Socket> socket, uint64_t baseIOUid)
-        : _onDisconnected(onDisconnected), _onRecv(onRecv), _socket(std::move(socket)), _baseIOUid(baseIOUid) {
+        Connection(BaseIO &io, decltype(_onDisconnected) &onDisconnected, decltype(_onRecv) &onRecv, BaseIO::AtomicIOStats &stats,
+                unique_ptr<Socket> socket, uint64_t baseIOUid)
+        : _io(io), _onDisconnected(onDisconnected), _onRecv(onRecv), _stats(stats), _socket(std::move(socket)), _baseIOUid(baseIOUid) {
         };
 
+        //makes pending reads and writes complete with an error, which then releases this connection
+        void close() {
+            _socket->close();
+        }
+
         ~Connection() override {
             VLOG(0) << "closing connection #" << _connectionUid << " (likely because no read/write operations are queued on it)";
             RNR_EXPECTS(_onDisconnected);
@@ -50,70 +74,178 @@ namespace riner {
         }
 
         void asyncWrite(std::string outgoing) override {
+            RNR_EXPECTS(_io.isIoThread()); //_writeQueue and _writeInProgress are not synchronized, see BaseIO::writeAsync
+            _writeQueue.push_back(std::move(outgoing));
+            if (!_writeInProgress) {
+                writeQueued(this->shared_from_this());
+            }
+        }
+
+        void asyncWrite(std::vector<std::string> outgoing) override {
+            RNR_EXPECTS(_io.isIoThread());
+            for (auto &str : outgoing) {
+                _writeQueue.push_back(std::move(str));
+            }
+            if (!_writeInProgress) {
+                writeQueued(this->shared_from_this());
+            }
+        }
+
+        void writeQueued(const shared_ptr<Connection> &shared) {
+            const size_t maxBuffersPerWrite = 64;
+
+            _writing.clear();
+            std::vector<asio::const_buffer> buffers;
+            size_t numBytes = 0;
+            while (!_writeQueue.empty() && _writing.size() < maxBuffersPerWrite) {
+                _writing.push_back(std::move(_writeQueue.front()));
+                _writeQueue.pop_front();
+                buffers.emplace_back(asio::buffer(_writing.back()));
+                numBytes += _writing.back().size();
+            }
+
+            _stats.messagesWritten.fetch_add(_writing.size(), std::memory_order_relaxed);
+            _stats.bytesWritten.fetch_add(numBytes, std::memory_order_relaxed);
+            _stats.writeOps.fetch_add(1, std::memory_order_relaxed);
+
             //capturing shared = shared_from_this() is critical here, it means that as long as the handler is not invoked
             //the refcount of this connection is kept above zero, and thus the connection is kept alive.
             //as soon as no async read or write action is queued on a given connection is, the connection will close itself
-            VLOG(4) << "async_write queued";
-            _socket->async_write(asio::buffer(outgoing), [outgoing, shared = this->shared_from_this()] (const asio::error_code &error, size_t numBytes) {
+            VLOG(4) << "async_write queued (" << _writing.size() << " messages)";
+            _writeInProgress = true;
+            _socket->async_write(buffers, _io.wrap([this, shared] (const asio::error_code &error, size_t numBytes) {
                 VLOG(4) << "async_write scheduled";
+                if (_io._shutdown) {
+                    return; //closed by BaseIO::stopIOThread
+                }
+                _writeInProgress = false;
                 if (error) {
-                    LOG(WARNING) << "async write error " << asio_error_name_num(error) <<
-                              " in Connection while trying to send '" << outgoing << "'";
+                    for (auto &outgoing : _writing) {
+                        LOG(WARNING) << "async write error " << asio_error_name_num(error) <<
+                                     " in Connection while trying to send '" << outgoing << "'";
+                    }
+                    _writeQueue.clear(); //the connection is broken, drop the rest as well
+                    return;
                 }
-            });
+                if (!_writeQueue.empty()) {
+                    writeQueued(shared);
+                }
+            }));
         }
 
         void asyncRead() override {
+            if (_dispatchingLines) {
+                //called from within _onRecv, the loop in deliverLinesOrRead() continues with the next buffered line
+                _readRequested = true;
+                return;
+            }
+            if (_socketReadPending) {
+                VLOG(4) << "asyncRead called while a read is already queued on connection #" << _connectionUid;
+                return;
+            }
+            deliverLinesOrRead(this->shared_from_this());
+        }
+
+        //delivers every complete line that is already buffered as long as the receiver keeps requesting reads (by
+        //calling asyncRead() from within _onRecv) and only queues a socket read if no complete line is left
+        void deliverLinesOrRead(const shared_ptr<Connection> &shared) {
+            while (true) {
+                const char *begin = _readBuffer.data() + _readBegin;
+                const char *end = _readBuffer.data() + _readEnd;
+                const char *newline = std::find(begin, end, '\n');
+                if (newline == end) {
+                    break; //no complete line buffered
+                }
+                std::string line(begin, newline); //without the '\n'
+                _readBegin += newline - begin + 1;
+
+                _readRequested = false;
+                _dispatchingLines = true;
+                RNR_EXPECTS(_onRecv);
+                try {
+                    _onRecv(CxnHandle{shared} //becomes weak_ptr<IOConnection> aka CxnHandle
+                            , line);
+                }
+                catch (...) {
+                    _dispatchingLines = false;
+                    throw;
+                }
+                _dispatchingLines = false;
+
+                if (!_readRequested) {
+                    return; //receiver didn't ask for further lines
+                }
+            }
+
+            //move the incomplete line to the front of the buffer and make room for more bytes
+            std::copy(_readBuffer.begin() + _readBegin, _readBuffer.begin() + _readEnd, _readBuffer.begin());
+            _readEnd -= _readBegin;
+            _readBegin = 0;
+            if (_readEnd == _readBuffer.size()) {
+                _readBuffer.resize(_readBuffer.size() * 2); //line longer than the buffer
+            }
+
             //capturing shared = shared_from_this() is critical here, it means that as long as the handler is not invoked
             //the refcount of this connection is kept above zero, and thus the connection is kept alive.
             //as soon as no async read or write action is queued on a given connection is, the connection will close itself
-            VLOG(4) << "read_until queued";
-            _socket->async_read_until(_incoming, '\n', [this, shared = this->shared_from_this()]
-                    (const asio::error_code &error, size_t numBytes) {
-
-                VLOG(4) << "read_until scheduled";
+            VLOG(4) << "read_some queued";
+            _socketReadPending = true;
+            auto buffer = asio::buffer(_readBuffer.data() + _readEnd, _readBuffer.size() - _readEnd);
+            _socket->async_read_some(buffer, _io.wrap([this, shared] (const asio::error_code &error, size_t numBytes) {
+
+                VLOG(4) << "read_some scheduled";
+                if (_io._shutdown) {
+                    return; //closed by BaseIO::stopIOThread
+                }
+                _socketReadPending = false;
                 if (error) {
                     if (error.value() == asio::error::eof) {
                         LOG(INFO) << "connection #" << _connectionUid << " closed from other side (eof)";
                     }
                     else {
-                        LOG(WARNING) << "asio error " << asio_error_name_num(error) << " during async_read_until: "
+                        LOG(WARNING) << "asio error " << asio_error_name_num(error) << " during async_read_some: "
                                      << error.message();
                     }
                     return;
                 }
 
-                std::string line;
-                {
-                    std::istream stream(&_incoming);
-                    std::getline(stream, line);
-                }
-
-                RNR_EXPECTS(line.size() == strlen(line.c_str()));
-
-                RNR_EXPECTS(_onRecv);
-                _onRecv(CxnHandle{shared} //becomes weak_ptr<IOConnection> aka CxnHandle
-                        , line);
-            });
+                _stats.bytesRead.fetch_add(numBytes, std::memory_order_relaxed);
+                _stats.readOps.fetch_add(1, std::memory_order_relaxed);
+                _readEnd += numBytes;
+                deliverLinesOrRead(shared);
+            }));
         }
 
     };
 
+    constexpr milliseconds BaseIO::connectAttemptDelay;
+
     BaseIO::~BaseIO() {
         RNR_EXPECTS(!isIoThread());
         stopIOThread();
         abortAllAsyncRetries();
-        //handlers get destroyed in _ioService dtor
+        //handlers get destroyed in _ioService dtor (or have already completed if _runtime is used)
     }
 
     BaseIO::BaseIO(const char *customIOThreadName, IOMode mode)
     : _mode(mode)
     , _customIOThreadName(customIOThreadName)
-    , _ioService(make_unique<asio::io_service>()) {
+    , _runtime(IORuntime::getShared()) {
+        if (!_runtime) {
+            _ioService = make_unique<asio::io_service>();
+        }
+        _strand = make_unique<asio::io_service::strand>(ioService());
         startIOThread();
     }
 
     void BaseIO::writeAsync(CxnHandle handle, value_type outgoing) {
+        if (!isIoThread()) {
+            //the connection's write queue is only accessed on the io thread
+            postAsync([this, handle, outgoing = std::move(outgoing)] () mutable {
+                writeAsync(handle, std::move(outgoing));
+            });
+            return;
+        }
 
         if (auto cxn = handle.lock(*this)) {
             cxn->asyncWrite(std::move(outgoing)); //cxn shared_ptr is captured inside this func's async handler (which prolongs it's lifetime)
@@ -123,6 +255,25 @@ namespace riner {
         }
     }
 
+    void BaseIO::writeAsync(CxnHandle handle, std::vector<value_type> outgoing) {
+        if (outgoing.empty()) {
+            return;
+        }
+        if (!isIoThread()) {
+            postAsync([this, handle, outgoing = std::move(outgoing)] () mutable {
+                writeAsync(handle, std::move(outgoing));
+            });
+            return;
+        }
+
+        if (auto cxn = handle.lock(*this)) {
+            cxn->asyncWrite(std::move(outgoing));
+        }
+        else {
+            VLOG(2) << "called writeAsync on connection that was closed";
+        }
+    }
+
     void BaseIO::readAsync(CxnHandle handle) {
         if (auto cxn = handle.lock(*this)) {
             cxn->asyncRead(); //cxn shared_ptr is captured inside this func's async handler (which prolongs it's lifetime)
@@ -139,6 +290,7 @@ namespace riner {
 
     void BaseIO::enableSsl(const SslDesc &desc) {
         _sslDesc = desc;
+        _sslContext.reset(); //created with the next socket
 #ifndef HAS_OPENSSL
         LOG(WARNING) << "cannot enableSsl() on BaseIO since binary was compiled without OpenSSL support. Recompilation with OpenSSL required.";
 #endif
@@ -152,6 +304,18 @@ namespace riner {
     }
 
     void BaseIO::startIOThread() {
+#ifdef RINER_IO_URING
+        if (!_ioUring) {
+            createIoUring();
+        }
+#endif
+        if (_runtime) {
+            RNR_EXPECTS(!_runtimeRunning);
+            _shutdown = false;
+            _runtimeRunning = true; //nothing to start, the runtime's threads are already running
+            return;
+        }
+
         RNR_EXPECTS(_thread == nullptr);
         if (_thread) {
             LOG(WARNING) << getIoThreadName() << ": 'launchIoThread' called after ioService thread was already started by another call. Ignoring this call.";
@@ -206,6 +370,28 @@ namespace riner {
         // A proper way of implementing this would be to have a std::lock_guard style RAII object that guards the io thread's scope on user side.
         // e.g. launchClient returns an IOThreadGuard which has a dtor that allows the io thread to stop
 
+        if (_runtime) {
+            if (_runtimeRunning) {
+                RNR_EXPECTS(!isIoThread());
+                _shutdown = true;
+
+                //the shared io_service keeps running, so instead of stopping it, close everything of this object on its
+                //strand and wait until all handlers of this object are done
+                postAsync([this] () {
+                    closeAll();
+                });
+
+                std::unique_lock<std::mutex> lock(_pendingHandlers->mutex);
+                _pendingHandlers->cv.wait(lock, [this] () {
+                    return _pendingHandlers->count == 0;
+                });
+
+                _runtimeRunning = false;
+                _hasLaunched = false;
+            }
+            return;
+        }
+
         if (_thread) {
             _shutdown = true;
 
@@ -220,10 +406,70 @@ namespace riner {
         RNR_ENSURES(!_thread);
     }
 
+    void BaseIO::closeAll() {
+        asio::error_code ignored;
+        if (_acceptor) {
+            _acceptor->close(ignored);
+        }
+        if (_resolver) {
+            _resolver->cancel();
+        }
+        if (_socket) {
+            _socket->tcpStream().close(ignored);
+        }
+        for (auto &weak : _connections) {
+            if (auto cxn = weak.lock()) {
+                cxn->close();
+            }
+        }
+        _connections.clear();
+        for (auto &weak : _pendingSockets) {
+            auto suSock = weak.lock();
+            if (suSock && *suSock) {
+                (*suSock)->tcpStream().close(ignored);
+            }
+        }
+        _pendingSockets.clear();
+        if (_connectRace) {
+            _connectRace->staggerTimer.cancel(ignored);
+        }
+        if (_reconnectTimer) {
+            _reconnectTimer->cancel(ignored);
+        }
+        for (auto &weak : _timers) {
+            if (auto timer = weak.lock()) {
+                timer->cancel(ignored);
+            }
+        }
+        _timers.clear();
+
+        for (auto &retry : *_activeRetries.lock()) {
+            retry->timer.cancel(ignored); //its handler leaves it in _activeRetries for abortAllAsyncRetries()
+        }
+#ifdef RINER_IO_URING
+        if (_ioUring) {
+            _ioUring->close(); //drops the handlers of the connections' reads and writes
+        }
+#endif
+    }
+
+    void BaseIO::trackPendingSocket(const shared_ptr<unique_ptr<Socket>> &suSock) {
+        _pendingSockets.remove_if([] (const weak_ptr<unique_ptr<Socket>> &weak) {
+            return weak.expired();
+        });
+        _pendingSockets.push_back(suSock);
+    }
+
     //used by client and server
     void BaseIO::createCxnWithSocket(unique_ptr<Socket> sock) { //TODO: make method const?
         RNR_EXPECTS(sock);
-        auto cxn = make_shared<Connection>(_onDisconnected, _onRecv, std::move(sock), _uid);
+        auto cxn = make_shared<Connection>(*this, _onDisconnected, _onRecv, _stats, std::move(sock), _uid);
+
+        _connections.remove_if([] (const weak_ptr<Connection> &weak) {
+            return weak.expired();
+        });
+        _connections.push_back(cxn);
+
         RNR_EXPECTS(_onConnected);
         _onConnected(CxnHandle{cxn}); //user is expected to use cxn here with other calls like readAsync(cxn)
     } //cxn refcount decremented and maybe destroyed if cxn was not used in _onConnected(cxn)
@@ -234,13 +480,12 @@ namespace riner {
         if (sslEnabledButNotSupported())
             return false;
 
-        RNR_EXPECTS(_ioService);
-        RNR_EXPECTS(_thread);
+        RNR_EXPECTS(ioThreadRunning());
         RNR_EXPECTS(!hasLaunched());
 
         try {
             VLOG(6) << "creating tcp::acceptor...";
-            _acceptor = make_unique<tcp::acceptor>(*_ioService, tcp::endpoint{tcp::v4(), port});
+            _acceptor = make_unique<tcp::acceptor>(ioService(), tcp::endpoint{tcp::v4(), port});
             VLOG(6) << "creating tcp::acceptor...done";
         }
         catch(const std::system_error &e) {
@@ -250,6 +495,7 @@ namespace riner {
         }
 
         RNR_EXPECTS(_acceptor);
+        _serverPort = _acceptor->local_endpoint().port(); //differs from port if port is 0 (any free port)
 
         _onConnected    = std::move(onCxn);
         _onDisconnected = std::move(onDc);
@@ -265,25 +511,29 @@ namespace riner {
         RNR_EXPECTS(_acceptor);
         RNR_EXPECTS(_socket);
         VLOG(6) << "async_accept queued";
-        _acceptor->async_accept(_socket->tcpStream(), [this] (const asio::error_code &error) { //socket operation
+        _acceptor->async_accept(_socket->tcpStream(), wrap([this] (const asio::error_code &error) { //socket operation
             VLOG(6) << "async_accept scheduled";
+            if (_shutdown) {
+                return; //closed by stopIOThread
+            }
             if (!error) {
                 bool isClient = false;
 
                 _socket->tcpStream().set_option(tcp::no_delay(true));
                 auto suSock = make_shared<unique_ptr<Socket>>(move(_socket)); //move out current socket
+                trackPendingSocket(suSock);
                 prepareSocket(isClient); //make new socket
 
                 VLOG(6) << "asyncHandshakeOrNoop queued (B)";
-                (*suSock)->asyncHandshakeOrNoop([this, suSock] (const asio::error_code &error) {
+                (*suSock)->asyncHandshakeOrNoop(wrapHandshake([this, suSock] (const asio::error_code &error) {
                     VLOG(6) << "asyncHandshakeOrNoop scheduled (B)";
                     if (*suSock) {
                         handshakeHandler(error, move(*suSock));
                     }
-                });
+                }));
             }
             serverListen();
-        });
+        }));
     }
 
     void BaseIO::resetIoService() {
@@ -291,21 +541,64 @@ namespace riner {
         _socket.reset();
         _acceptor.reset();
         _resolver.reset();
-        _ioService = make_unique<asio::io_service>();
+        _connections.clear();
+        _pendingSockets.clear();
+        _connectRace.reset();
+        _reconnectTimer.reset();
+        _timers.clear();
+#ifdef RINER_IO_URING
+        _ioUring.reset(); //drops the handlers of pending reads and writes, like replacing the io_service below. recreated by startIOThread()
+#endif
+        if (!_runtime) {
+            _strand.reset();
+            _ioService = make_unique<asio::io_service>();
+            _strand = make_unique<asio::io_service::strand>(*_ioService);
+        }
     }
 
     void BaseIO::prepareSocket(bool isClient) {
-        RNR_EXPECTS(_ioService);
         VLOG(6) << "prepareSocket...";
+        _socket = createSocket(isClient);
+        VLOG(6) << "prepareSocket...done";
+    }
+
+    unique_ptr<Socket> BaseIO::createSocket(bool isClient) {
         if (_sslDesc) { //create ssl socket
-            _socket = make_unique<Socket>(*_ioService, isClient, _sslDesc.value());
+            if (!_sslContext || _sslContext->isClient() != isClient) {
+                _sslContext = make_shared<SslContext>(_sslDesc.value(), isClient);
+            }
+            return make_unique<Socket>(ioService(), _sslContext);
         }
         else { //create tcp socket
-            _socket = make_unique<Socket>(*_ioService, isClient);
+#ifdef RINER_IO_URING
+            return make_unique<Socket>(ioService(), isClient, _ioUring.get());
+#else
+            return make_unique<Socket>(ioService(), isClient);
+#endif
+        }
+    }
+
+#ifdef RINER_IO_URING
+    void BaseIO::createIoUring() {
+        _ioUring = IoUring::tryCreate(ioService(), [this] (std::function<void()> func) {
+            postAsync(std::move(func));
+        });
+        if (_ioUring) {
+            waitForIoUringCompletions();
         }
-        VLOG(6) << "prepareSocket...done";
     }
 
+    void BaseIO::waitForIoUringCompletions() {
+        _ioUring->asyncWaitForCompletions(wrap([this] (const asio::error_code &error, size_t) {
+            if (error || _shutdown) {
+                return; //closed by closeAll() or by resetting _ioUring
+            }
+            _ioUring->dispatchCompletions();
+            waitForIoUringCompletions();
+        }));
+    }
+#endif
+
     std::string BaseIO::getIoThreadName() const {
         std::string name = "io#" + std::to_string(_uid);
         if (0 != strcmp(_customIOThreadName, ""))
@@ -313,14 +606,30 @@ namespace riner {
         return name;
     }
 
+    std::vector<tcp::endpoint> BaseIO::interleaveAddressFamilies(const std::vector<tcp::endpoint> &endpoints) {
+        std::vector<tcp::endpoint> preferred, other;
+        bool preferV6 = !endpoints.empty() && endpoints.front().address().is_v6();
+        for (auto &endpoint : endpoints) {
+            (endpoint.address().is_v6() == preferV6 ? preferred : other).push_back(endpoint);
+        }
+
+        std::vector<tcp::endpoint> result;
+        for (size_t i = 0; i < std::max(preferred.size(), other.size()); ++i) {
+            if (i < preferred.size())
+                result.push_back(preferred[i]);
+            if (i < other.size())
+                result.push_back(other[i]);
+        }
+        return result;
+    }
+
     //functions used by client
-    void BaseIO::launchClient(std::string host, uint16_t port, IOOnConnectedFunc &&onCxn, IOOnDisconnectedFunc &&onDc) {
+    bool BaseIO::prepareLaunchClient(IOOnConnectedFunc &&onCxn, IOOnDisconnectedFunc &&onDc) {
         VLOG(3) << getIoThreadName() << " trying to launch client";
         if (sslEnabledButNotSupported())
-            return;
+            return false;
 
-        RNR_EXPECTS(_ioService);
-        RNR_EXPECTS(_thread);
+        RNR_EXPECTS(ioThreadRunning());
         RNR_EXPECTS(!hasLaunched());
         _hasLaunched = true;
 
@@ -331,73 +640,138 @@ namespace riner {
         };
         RNR_ENSURES(_onDisconnected);
         RNR_ENSURES(_onConnected);
+        return true;
+    }
 
-        _resolver = make_unique<tcp::resolver>(*_ioService);
-        bool isClient = true;
-        prepareSocket(isClient);
+    void BaseIO::launchClient(std::string host, uint16_t port, IOOnConnectedFunc &&onCxn, IOOnDisconnectedFunc &&onDc) {
+        if (!prepareLaunchClient(std::move(onCxn), std::move(onDc)))
+            return;
+
+        _resolver = make_unique<tcp::resolver>(ioService());
 
         tcp::resolver::query query{host, std::to_string(port)};
 
         VLOG(6) << "async_resolve queued";
-        _resolver->async_resolve(query, [this] (auto &error, auto it) {
+        _resolver->async_resolve(query, wrap([this, host] (auto &error, auto it) {
             VLOG(6) << "async_resolve scheduled";
-            if (!error) {
-                auto endpoint = *it;
-                VLOG(6) << "async_connect queued (A)";
-                _socket->tcpStream().async_connect(endpoint, [this, it] (auto &error) { //socket operation
-                    VLOG(6) << "async_connect scheduled (A)";
-                    clientIterateEndpoints(error, it);
-                });
+            if (_shutdown) {
+                return; //cancelled by stopIOThread
             }
-            else {
+            if (error) {
                 LOG(ERROR) << "asio could not resolve query. Error #" << error.value() << ", " << error.message();
                 _onDisconnected();
+                return;
             }
-        });
-    }
 
-    void BaseIO::clientIterateEndpoints(const asio::error_code &error, tcp::resolver::iterator it) {
-        RNR_EXPECTS(_resolver);
-        auto it_end = tcp::resolver::iterator(); //default constructed iterator is "end"
-        if (it == it_end) {
-            if (error) {
-                VLOG(3) << "async connect: " << asio_error_name_num(error) << ": " << error.message();
+            std::vector<tcp::endpoint> endpoints;
+            for (; it != tcp::resolver::iterator(); ++it) {
+                endpoints.push_back(it->endpoint());
             }
-	    else {
-                VLOG(3) << "async connect failed: no endpoint available";
+            raceEndpoints(host, interleaveAddressFamilies(endpoints));
+        }));
+    }
+
+    void BaseIO::launchClient(std::vector<tcp::endpoint> endpoints, IOOnConnectedFunc &&onCxn, IOOnDisconnectedFunc &&onDc) {
+        if (!prepareLaunchClient(std::move(onCxn), std::move(onDc)))
+            return;
+
+        std::string host = endpoints.empty() ? "" : endpoints.front().address().to_string();
+        postAsync([this, host, endpoints = std::move(endpoints)] () mutable {
+            if (_shutdown) {
+                return;
             }
+            raceEndpoints(host, std::move(endpoints));
+        });
+    }
+
+    //called on the io thread
+    void BaseIO::raceEndpoints(std::string host, std::vector<tcp::endpoint> endpoints) {
+        if (endpoints.empty()) {
+            VLOG(3) << "async connect failed: no endpoint available";
             _onDisconnected();
+            return;
+        }
+        _connectRace = make_shared<ConnectRace>(ioService(), std::move(host));
+        _connectRace->endpoints = std::move(endpoints);
+        raceNextEndpoint(_connectRace);
+    }
+
+    //starts a connection attempt to the next endpoint of the race and schedules the attempt after that, so that a dead
+    //endpoint only delays the connection by connectAttemptDelay instead of a full connect timeout
+    void BaseIO::raceNextEndpoint(const shared_ptr<ConnectRace> &race) {
+        if (race->won || race->next >= race->endpoints.size()) {
+            return;
         }
-        else if (!error) {
-            VLOG(0) << "successfully connected to '" << it->host_name() << ':' << it->service_name() << "'";
+        tcp::endpoint endpoint = race->endpoints[race->next++];
+        auto suSock = make_shared<unique_ptr<Socket>>(createSocket(true));
+        trackPendingSocket(suSock);
+        race->attempts.push_back(suSock);
+        ++race->pending;
+
+        VLOG(3) << "trying endpoint " << endpoint << " of '" << race->host << "' (" << race->next << "/" << race->endpoints.size() << ")";
+        VLOG(6) << "async_connect queued";
+        (*suSock)->tcpStream().async_connect(endpoint, wrap([this, race, suSock, endpoint] (const asio::error_code &error) { //socket operation
+            VLOG(6) << "async_connect scheduled";
+            if (_shutdown || race->won) {
+                return; //another attempt was faster, this socket is closed together with the handler
+            }
+            if (error) {
+                VLOG(2) << "when trying endpoint " << endpoint << " - " << asio_error_name_num(error) << ": " << error.message();
+                raceAttemptFailed(race);
+                return;
+            }
+            VLOG(0) << "successfully connected to '" << race->host << "' (" << endpoint << ")";
 
-            //std::function that the upcoming lambda will be converted to demands copyability. so no unique_ptrs may be captured.
-            _socket->tcpStream().set_option(tcp::no_delay(true));
-            auto suSock = make_shared<unique_ptr<Socket>>(move(_socket));
+            asio::error_code ignored;
+            (*suSock)->tcpStream().set_option(tcp::no_delay(true), ignored);
 
             VLOG(6) << "asyncHandshakeOrNoop queued (A)";
-            (*suSock)->asyncHandshakeOrNoop([this, suSock] (const asio::error_code &error) mutable {
+            (*suSock)->asyncHandshakeOrNoop(wrapHandshake([this, race, suSock] (const asio::error_code &error) {
                 VLOG(6) << "asyncHandshakeOrNoop scheduled (A)";
-                if (*suSock) {
-                    handshakeHandler(error, std::move(*suSock));
+                if (_shutdown || race->won || !*suSock) {
+                    return;
+                }
+                if (error) {
+                    VLOG(1) << "asio async client handshake: Error #" << error << ": " << error.message();
+                    raceAttemptFailed(race);
+                    return;
+                }
+
+                //first attempt that is ready for use, drop the others
+                race->won = true;
+                asio::error_code ignored;
+                race->staggerTimer.cancel(ignored);
+                for (auto &attempt : race->attempts) {
+                    if (attempt != suSock && *attempt) {
+                        (*attempt)->tcpStream().close(ignored);
+                    }
                 }
-            }, it->host_name());
+                race->attempts.clear();
+                handshakeHandler(error, std::move(*suSock));
+            }), race->host);
+        }));
+
+        race->staggerTimer.expires_after(connectAttemptDelay); //cancels the previous wait
+        race->staggerTimer.async_wait(wrap([this, race] (const asio::error_code &error) {
+            if (!error && !_shutdown) {
+                raceNextEndpoint(race); //the current attempts are slow, try the next endpoint in parallel
+            }
+        }));
+    }
+
+    void BaseIO::raceAttemptFailed(const shared_ptr<ConnectRace> &race) {
+        RNR_EXPECTS(race->pending > 0);
+        --race->pending;
+
+        if (race->next < race->endpoints.size()) {
+            raceNextEndpoint(race); //no need to wait for the stagger timer
         }
-        else {
-            //The connection failed, but there's another endpoint to try.
-            _socket->tcpStream().close(); //socket operation
-
-            tcp::endpoint endpoint = *it;
-            VLOG(2) << "when trying endpoint "<< it->host_name() << ":" << it->service_name() <<" - " << asio_error_name_num(error) << ": " << error.message();
-            auto next = ++it;
-            if (next != it_end) {
-                VLOG(3) << "now trying different endpoint "<< next->host_name() << ":" << next->service_name();
-            }
-            VLOG(6) << "async_connect queued (B)";
-            _socket->tcpStream().async_connect(endpoint, [this, next] (const auto &error) { //socket operation
-                VLOG(6) << "async_connect scheduled (B)";
-                clientIterateEndpoints(error, next);
-            });
+        else if (race->pending == 0) {
+            VLOG(3) << "async connect failed: no endpoint of '" << race->host << "' left to try";
+            asio::error_code ignored;
+            race->staggerTimer.cancel(ignored);
+            race->attempts.clear();
+            _onDisconnected();
         }
     }
 
@@ -407,7 +781,12 @@ namespace riner {
     void BaseIO::handshakeHandler(const asio::error_code &error, unique_ptr<Socket> sock) { //TODO: make method const?
         if (!error) {
             if (_sslDesc) { //if ssl is enabled a handshake happened successfully, otherwise nothing happened... successfully!
-                VLOG(1) << "successfully performed handshake";
+                bool resumed = sock->sslSessionReused();
+                VLOG(1) << "successfully performed handshake" << (resumed ? " (resumed session)" : " (full handshake)");
+                ++_stats.sslHandshakes;
+                if (resumed) {
+                    ++_stats.sslResumedSessions;
+                }
             }
             createCxnWithSocket(std::move(sock));
         }
@@ -420,7 +799,7 @@ namespace riner {
     }
 
     void BaseIO::launchClientAutoReconnect(std::string host, uint16_t port, IOOnConnectedFunc &&onConnected, IOOnDisconnectedFunc &&onDisconnected) {
-        RNR_EXPECTS(_thread && !hasLaunched());
+        RNR_EXPECTS(ioThreadRunning() && !hasLaunched());
         auto failedTriesToConnect = make_shared<int>(0);
 
         _onConnected = [onConnected = std::move(onConnected), failedTriesToConnect] (CxnHandle cxn) {
@@ -428,22 +807,7 @@ namespace riner {
             onConnected(std::move(cxn));
         };
 
-        auto connect = [this, host, port, failedTriesToConnect] () {
-            //if connecting has failed last time, wait a little bit before trying again
-            if (*failedTriesToConnect > 0) {
-                int singleWaitMs = 500; //this is the interval in which _shutdown is checked
-                int totalWaitMs = std::max(*failedTriesToConnect, 20) * singleWaitMs;
-
-                for (; totalWaitMs >= 0; totalWaitMs -= singleWaitMs) {
-                    if (this->_shutdown)
-                        break;
-                    std::this_thread::sleep_for(std::chrono::milliseconds(singleWaitMs));
-                }
-            }
-
-            if (this->_shutdown) //check after wait, because shutdown status may have changed since
-                return;
-
+        auto launch = [this, host, port, failedTriesToConnect] () {
             ++*failedTriesToConnect;
 
             auto onCxn = std::move(_onConnected); //create temporaries to move from
@@ -451,6 +815,26 @@ namespace riner {
             launchClient(host, port, std::move(onCxn), std::move(onDc));
         };
 
+        auto connect = [this, launch, failedTriesToConnect] () {
+            if (this->_shutdown)
+                return;
+
+            if (*failedTriesToConnect == 0) {
+                launch();
+                return;
+            }
+
+            //if connecting has failed last time, wait a little bit before trying again. the io thread must not be
+            //blocked meanwhile, since it may be shared with other io objects (see IORuntime)
+            auto delay = std::max(*failedTriesToConnect, 20) * milliseconds(500);
+            _reconnectTimer = make_unique<asio::steady_timer>(ioService(), delay);
+            _reconnectTimer->async_wait(wrap([this, launch] (const asio::error_code &error) {
+                if (error || this->_shutdown) //check after wait, because shutdown status may have changed since
+                    return;
+                launch();
+            }));
+        };
+
         _onDisconnected = [&, connect, onDisconnected = std::move(onDisconnected)] () {
             onDisconnected(); //call user defined callback first
             connect(); //then attempt reconnect
@@ -492,7 +876,7 @@ namespace riner {
     void BaseIO::retryAsyncEvery(milliseconds interval, std::function<bool()> &&pred, std::function<void()> &&onCancelled) {
 
         auto shared = std::shared_ptr<AsyncRetry>(new AsyncRetry {
-                {*_ioService, interval}, std::move(pred), std::move(onCancelled), {}
+                {ioService(), interval}, std::move(pred), std::move(onCancelled), {}
         });
 
         auto weak = make_weak(shared);
@@ -516,6 +900,10 @@ namespace riner {
 
             if (auto shared = weak.lock()) {
 
+                if (_shutdown) {
+                    return; //stopped by stopIOThread, onCancelled is called by abortAllAsyncRetries()
+                }
+
                 if (error == asio::error::operation_aborted) {
                     shared->onCancelled();
                 }
@@ -533,9 +921,9 @@ namespace riner {
                     return;
                 }
                 else {
-                    shared->timer = asio::steady_timer{*_ioService, interval};
+                    shared->timer = asio::steady_timer{ioService(), interval};
                     VLOG(6) << "async_wait waitHandler queued";
-                    shared->timer.async_wait(shared->waitHandler);
+                    shared->timer.async_wait(wrap(shared->waitHandler));
                 }
 
             }
@@ -549,6 +937,36 @@ namespace riner {
         });
     }
 
+    void BaseIO::postAsyncAt(clock::time_point time, std::function<void()> &&func) {
+        postAsync([this, time, func = std::move(func)] () mutable {
+            auto timer = make_shared<asio::steady_timer>(ioService(), time);
+            _timers.remove_if([] (const weak_ptr<asio::steady_timer> &weak) {
+                return weak.expired();
+            });
+            _timers.push_back(timer);
+
+            VLOG(6) << "async_wait queued (postAsyncAt)";
+            timer->async_wait(wrap([this, timer, func = std::move(func)] (const asio::error_code &error) {
+                if (error || _shutdown) {
+                    return; //cancelled by closeAll
+                }
+                func();
+            }));
+        });
+    }
+
+    IOStats BaseIO::getIOStats() const {
+        IOStats stats;
+        stats.messagesWritten = _stats.messagesWritten.load(std::memory_order_relaxed);
+        stats.bytesWritten = _stats.bytesWritten.load(std::memory_order_relaxed);
+        stats.writeOps = _stats.writeOps.load(std::memory_order_relaxed);
+        stats.bytesRead = _stats.bytesRead.load(std::memory_order_relaxed);
+        stats.readOps = _stats.readOps.load(std::memory_order_relaxed);
+        stats.sslHandshakes = _stats.sslHandshakes.load(std::memory_order_relaxed);
+        stats.sslResumedSessions = _stats.sslResumedSessions.load(std::memory_order_relaxed);
+        return stats;
+    }
+
     uint64_t BaseIO::getUid() {
         return _uid;
     }
@@ -561,16 +979,23 @@ namespace riner {
         return _hasLaunched;
     }
 
+    uint16_t BaseIO::serverPort() const {
+        return _serverPort;
+    }
+
     void BaseIO::setIoThreadId() {
         _ioThreadId = std::this_thread::get_id();
     }
 
     bool BaseIO::isIoThread() const {
+        if (_runtime) {
+            return _strand->running_in_this_thread();
+        }
         return std::this_thread::get_id() == _ioThreadId;
     }
 
     bool BaseIO::ioThreadRunning() const {
-        return (bool)_thread;
+        return _runtime ? _runtimeRunning : (bool)_thread;
     }
 
 }
@@ -11,7 +11,12 @@
 #include <src/util/Copy.h>
 #include <src/util/LockUtils.h>
 #include <list>
+#include <atomic>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
 #include "Socket.h"
+#include "IORuntime.h"
 
 namespace riner {
 
@@ -21,6 +26,7 @@ namespace riner {
 
         //this function is not exposed to prevent confusion with the type layers
         virtual void asyncWrite(std::string outgoingStr) = 0;
+        virtual void asyncWrite(std::vector<std::string> outgoingStrs) = 0; //sent together with a single gather write
         virtual void asyncRead() = 0;
 
         //a connection is always associated with a BaseIO instance. This getter is used to catch the error where a
@@ -31,13 +37,20 @@ namespace riner {
         virtual ~IOConnection() = default;
     };
 
+    struct Connection;
+
     /**
      * `BaseIO` is the bottom most IOTypeLayer (that doesn't actually derive from IOTypeLayer, as it has no successor).
      * It implements the actual IO logic based on `std::string` lines (ending with a `'\n'` character)
+     *
+     * By default a `BaseIO` runs its own io thread. If `IORuntime::getShared()` returns a runtime at construction,
+     * that runtime's threads are used instead. All handlers of this object then run on a strand, so they are still
+     * never executed in parallel, and "the io thread" means "inside this object's strand".
      */
     class BaseIO {
         template<class U, class V>
         friend class IOTypeLayer;
+        friend struct Connection;
     public:
         using value_type = std::string;
         using OnReceiveValueFunc = IOOnReceiveValueFunc<value_type>;
@@ -58,38 +71,122 @@ namespace riner {
         //launch as server or client, once launched cannot be changed for an instance
         bool launchServer(uint16_t listenOnPort, IOOnConnectedFunc &&, IOOnDisconnectedFunc && = ioOnDisconnectedNoop);
         void launchClient(std::string host, uint16_t port, IOOnConnectedFunc &&, IOOnDisconnectedFunc && = ioOnDisconnectedNoop);
+        //like above, but connects to the given endpoints (tried in the given order) instead of resolving a host
+        void launchClient(std::vector<asio::ip::tcp::endpoint> endpoints, IOOnConnectedFunc &&, IOOnDisconnectedFunc && = ioOnDisconnectedNoop);
 
         //only reconnects if the connection was NOT closed due to
         // - this BaseIO object being destroyed
         // - disconnectAll() being called on this object //if you want to have reconnect functionality in this case, call launchClientAutoReconnect again after disconnectAll()
         void launchClientAutoReconnect(std::string host, uint16_t port, IOOnConnectedFunc &&, IOOnDisconnectedFunc && = ioOnDisconnectedNoop);
 
+        //can be called from any thread, writes from other threads are posted to the io thread
         void writeAsync(CxnHandle, value_type outgoing);
+        void writeAsync(CxnHandle, std::vector<value_type> outgoing); //sends all lines with a single socket write
         void readAsync(CxnHandle);
 
         void setOnReceive(OnReceiveValueFunc &&);
 
         bool hasLaunched() const; //can be called from any thread (thread safe)
 
+        uint16_t serverPort() const; //port the server listens on (useful after launchServer(0, ...)), 0 if no server was launched. thread safe
+
         bool isIoThread() const;
 
         template<class Fn>
         void postAsync(Fn &&func) {
-            asio::post(*_ioService, std::forward<Fn>(func));
+            asio::post(ioService(), wrap(std::forward<Fn>(func)));
         }
         void retryAsyncEvery(milliseconds interval, std::function<bool()> &&pred, std::function<void()> &&onCancelled);
+        void postAsyncAt(clock::time_point time, std::function<void()> &&func); //func is dropped if the io thread stops before
 
         uint64_t getUid();
 
         void disconnectAll();
+
+        IOStats getIOStats() const; //can be called from any thread (thread safe)
+
+        //delay after which launchClient tries the next resolved endpoint in parallel if the current attempt has not
+        //succeeded yet ("Connection Attempt Delay" of happy eyeballs, RFC 8305)
+        static constexpr milliseconds connectAttemptDelay {250};
+
+        //orders the endpoints like happy eyeballs (RFC 8305): alternating between IPv6 and IPv4, starting with the family
+        //of the first endpoint and keeping the order within each family
+        static std::vector<asio::ip::tcp::endpoint> interleaveAddressFamilies(const std::vector<asio::ip::tcp::endpoint> &);
+
+        //counters that are updated by the connections on the io thread
+        struct AtomicIOStats {
+            std::atomic<uint64_t> messagesWritten {0};
+            std::atomic<uint64_t> bytesWritten {0};
+            std::atomic<uint64_t> writeOps {0};
+            std::atomic<uint64_t> bytesRead {0};
+            std::atomic<uint64_t> readOps {0};
+            std::atomic<uint64_t> sslHandshakes {0};
+            std::atomic<uint64_t> sslResumedSessions {0};
+        };
     protected:
         void stopIOThread(); //blocking, joins the io thread, no parallel handler execution is happening after this function returns
         bool ioThreadRunning() const; //not thread safe
 
     private:
+        //counts the handlers that are wrapped by wrap() and not yet destroyed, so that stopIOThread() can wait for them
+        //if a shared IORuntime is used (where the io_service cannot simply be stopped)
+        struct PendingHandlers {
+            std::mutex mutex;
+            std::condition_variable cv;
+            size_t count = 0;
+        };
+
+        class HandlerToken {
+            shared_ptr<PendingHandlers> _pending;
+        public:
+            explicit HandlerToken(shared_ptr<PendingHandlers> pending) : _pending(std::move(pending)) {
+                std::lock_guard<std::mutex> lock(_pending->mutex);
+                ++_pending->count;
+            }
+            HandlerToken(const HandlerToken &other) : HandlerToken(other._pending) {
+            }
+            HandlerToken &operator=(const HandlerToken &) = delete;
+            ~HandlerToken() {
+                std::lock_guard<std::mutex> lock(_pending->mutex);
+                if (--_pending->count == 0)
+                    _pending->cv.notify_all();
+            }
+        };
+
+        shared_ptr<PendingHandlers> _pendingHandlers = std::make_shared<PendingHandlers>();
+
+        //every handler that is passed to asio goes through this function, so that it runs on this object's strand
+        template<class Handler>
+        auto wrap(Handler &&handler) {
+            return asio::bind_executor(*_strand, [token = HandlerToken{_pendingHandlers}, handler = std::forward<Handler>(handler)] (auto &&... args) mutable {
+                handler(std::forward<decltype(args)>(args)...);
+            });
+        }
+
+        //Socket::HandshakeFunc is a std::function, which drops the strand that wrap() associates with the handler,
+        //so the returned function dispatches to it explicitly
+        template<class Handler>
+        auto wrapHandshake(Handler &&handler) {
+            return [this, wrapped = wrap(std::forward<Handler>(handler))] (const asio::error_code &error) {
+                asio::dispatch(*_strand, std::bind(wrapped, error));
+            };
+        }
+
+        asio::io_service &ioService() {
+            return _runtime ? _runtime->ioService() : *_ioService;
+        }
+
+        void closeAll(); //closes all sockets and cancels all timers, so that their handlers complete
+        void trackPendingSocket(const shared_ptr<unique_ptr<Socket>> &);
+
         void createCxnWithSocket(unique_ptr<Socket>);
         void serverListen();
-        void clientIterateEndpoints(const asio::error_code &error, asio::ip::tcp::resolver::iterator it);
+
+        bool prepareLaunchClient(IOOnConnectedFunc &&, IOOnDisconnectedFunc &&); //returns false if the client can't be launched
+        struct ConnectRace;
+        void raceEndpoints(std::string host, std::vector<tcp::endpoint> endpoints);
+        void raceNextEndpoint(const shared_ptr<ConnectRace> &);
+        void raceAttemptFailed(const shared_ptr<ConnectRace> &);
         void handshakeHandler(const asio::error_code &error, unique_ptr<Socket>); //takes ownership of socket already
 
         IOMode _mode;
@@ -111,6 +208,11 @@ namespace riner {
 
         void resetIoService();
 
+#ifdef RINER_IO_URING
+        void createIoUring(); //leaves _ioUring nullptr if io_uring is not available
+        void waitForIoUringCompletions();
+#endif
+
         struct AsyncRetry;
         LockGuarded<std::list<shared_ptr<AsyncRetry>>> _activeRetries;
 
@@ -123,29 +225,59 @@ namespace riner {
             WaitHandler waitHandler;
         };
 
+        struct ConnectRace { //used to store state of the parallel connection attempts of launchClient
+            std::string host;
+            std::vector<tcp::endpoint> endpoints; //in the order in which they are tried
+            size_t next = 0; //index of the next endpoint to try
+            size_t pending = 0; //attempts that are connecting or handshaking
+            bool won = false; //an attempt has completed its handshake, all others are dropped
+            asio::steady_timer staggerTimer;
+            std::vector<shared_ptr<unique_ptr<Socket>>> attempts;
+
+            ConnectRace(asio::io_service &ioService, std::string host)
+            : host(std::move(host)), staggerTimer(ioService) {
+            }
+        };
+        shared_ptr<ConnectRace> _connectRace; //of the current launchClient
+        unique_ptr<asio::steady_timer> _reconnectTimer; //delays the reconnects of launchClientAutoReconnect
+        std::list<weak_ptr<asio::steady_timer>> _timers; //of postAsyncAt, so that closeAll() can cancel them, only accessed on the io thread
+
         IOOnConnectedFunc _onConnected = ioOnConnectedNoop;
         IOOnDisconnectedFunc _onDisconnected = ioOnDisconnectedNoop;
 
         //TODO: refactor the BaseIO object to be just a wrapper around a unique_ptr that owns the actual BaseIO object (and while you're at it, make it 2 different ones for server and client). that way it can all be restarted in a RAII fashion without crazy dependencies like expressed below
         unique_ptr<asio::io_service> _ioService; //IMPORTANT: sadly, *_ioService refs are stored in the asio::steady_timers inside _activeRetries. abortAllAsyncRetries() must be called before resetting this unique_ptr.
         // _ioService must be declared after _onDisconnected since stop() may call _onDisconnected().
-
-        //socket depends on _ioService. gets moved into new connections as they are constructed
+        shared_ptr<IORuntime> _runtime; //if not nullptr, its io_service is used instead of _ioService and _thread
+        unique_ptr<asio::io_service::strand> _strand; //on ioService()
+        bool _runtimeRunning = false; //the equivalent of _thread if _runtime is used
+#ifdef RINER_IO_URING
+        unique_ptr<IoUring> _ioUring; //reads and writes of the non-ssl sockets, declared after _strand since its handlers are wrapped on it
+#endif
+        std::list<weak_ptr<Connection>> _connections; //so that closeAll() can reach them, only accessed on the io thread
+        std::list<weak_ptr<unique_ptr<Socket>>> _pendingSockets; //sockets that are connecting or handshaking, see _connections
+
+        //socket depends on _ioService. gets moved into new connections as they are constructed (server only, the client
+        //creates one socket per connection attempt)
         //can be a plain old tcp::socket or a ssl stream around a tcp::socket
         optional<SslDesc> _sslDesc;
+        shared_ptr<SslContext> _sslContext; //created from _sslDesc for the first socket, shared by all following ones
         unique_ptr<Socket> _socket;
 
         unique_ptr<tcp::acceptor> _acceptor; //for server
+        std::atomic<uint16_t> _serverPort {0};
         unique_ptr<tcp::resolver> _resolver; //for client
 
 
         OnReceiveValueFunc _onRecv = ioOnReceiveValueNoop<value_type>; //_onRecv referenced by instances of Connection<T>;
+        AtomicIOStats _stats; //referenced by instances of Connection
         std::atomic_bool _shutdown {false};
         std::atomic_bool _hasLaunched {false};
 
         unique_ptr<std::thread> _thread;
 
         void prepareSocket(bool isClient);
+        unique_ptr<Socket> createSocket(bool isClient);
 
         bool sslEnabledButNotSupported();
     };
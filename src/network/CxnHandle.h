@@ -27,6 +27,8 @@ namespace riner {
 
         size_t id() const {return ioConnectionUidCopy;} //for debugging
 
+        bool closed() const {return _weakPtr.expired();} //true from the connection's onDisconnected call on
+
         explicit CxnHandle(weak_ptr<IOConnection> movedArg);
 
     };
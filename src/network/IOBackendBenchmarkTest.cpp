@@ -0,0 +1,192 @@
+
+#include <src/network/JsonRpcBuilder.h>
+#include <src/network/JsonRpcUtil.h>
+#include <src/network/IORuntime.h>
+#include <src/util/Barrier.h>
+#include <src/common/Chrono.h>
+
+#include <gtest/gtest.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <numeric>
+
+namespace riner {
+    using namespace jrpc;
+    using namespace std::chrono_literals;
+    using RB = RequestBuilder;
+
+    //these benchmarks compare the network io backends (see IORuntime::backendName()) on loopback. the backend is chosen
+    //at compile time, so build once with and once without the cmake option RINER_IO_URING and compare the output.
+    //run with --gtest_also_run_disabled_tests --gtest_filter='IOBackend.*'
+    //asio operations per message are reported from the IOStats, context switches and kernel time from getrusage.
+    //syscalls can't be counted from within the process, count them by running a single benchmark under strace:
+    //  strace -f -c -o syscalls.txt ./tests --gtest_also_run_disabled_tests --gtest_filter='IOBackend.DISABLED_BenchmarkPoolRoundTrips'
+    //and divide the calls of sendmsg, recvmsg, epoll_wait and io_uring_enter in syscalls.txt by the printed message count
+    namespace {
+
+        //process wide (all threads)
+        struct Usage {
+            long contextSwitches = 0;
+            clock::duration kernelTime {};
+
+            static Usage now() {
+                using namespace std::chrono;
+                rusage usage {};
+                getrusage(RUSAGE_SELF, &usage);
+                auto kernelTime = seconds(usage.ru_stime.tv_sec) + microseconds(usage.ru_stime.tv_usec);
+                return {usage.ru_nvcsw + usage.ru_nivcsw, duration_cast<clock::duration>(kernelTime)};
+            }
+
+            Usage operator-(const Usage &rhs) const {
+                return {contextSwitches - rhs.contextSwitches, kernelTime - rhs.kernelTime};
+            }
+        };
+
+        struct Report {
+            size_t messages = 0;
+            clock::duration total {};
+            std::vector<clock::duration> latencies; //round trips, if measured
+            IOStats client {};
+            IOStats server {};
+            Usage usage {};
+
+            void print(const char *name) {
+                using namespace std::chrono;
+                auto perMsg = [&] (uint64_t n) {
+                    return double(n) / messages;
+                };
+                auto us = [] (clock::duration d) {
+                    return duration_cast<duration<double, std::micro>>(d).count();
+                };
+
+                std::cout << name << " (" << IORuntime::backendName() << "): " << messages << " messages in "
+                          << duration_cast<milliseconds>(total).count() << "ms\n";
+                if (!latencies.empty()) {
+                    std::sort(latencies.begin(), latencies.end());
+                    auto mean = std::accumulate(latencies.begin(), latencies.end(), clock::duration{}) / latencies.size();
+                    std::cout << "  round trip us: mean " << us(mean)
+                              << ", p50 " << us(latencies[latencies.size() / 2])
+                              << ", p99 " << us(latencies[latencies.size() * 99 / 100]) << "\n";
+                }
+                std::cout << "  client ops/msg: write " << perMsg(client.writeOps) << ", read " << perMsg(client.readOps) << "\n"
+                          << "  server ops/msg: write " << perMsg(server.writeOps) << ", read " << perMsg(server.readOps) << "\n"
+                          << "  context switches/msg: " << perMsg(uint64_t(usage.contextSwitches))
+                          << ", kernel time/msg us: " << us(usage.kernelTime) / messages << "\n";
+            }
+        };
+
+        //returns the port the server listens on
+        uint16_t launchStandInServer(JsonRpcUtil &server) {
+            server.launchServer(0, [&server] (CxnHandle cxn) {
+                server.setReadAsyncLoopEnabled(true);
+                server.readAsync(cxn);
+            });
+            return server.serverPort();
+        }
+
+    }
+
+    TEST(IOBackend, DISABLED_BenchmarkPoolRoundTrips) {
+        //a client submits shares to a stand-in pool one at a time, like a single pool connection does
+
+        const size_t count = 20000;
+        Barrier barrier;
+        Report report;
+        report.messages = count;
+        report.latencies.reserve(count);
+
+        JsonRpcUtil server{"bench server"};
+        JsonRpcUtil client{"bench client"};
+
+        server.addMethod("mining.submit", [] () {
+            return true;
+        });
+
+        clock::time_point sent;
+        std::function<void(CxnHandle, size_t)> submit = [&] (CxnHandle cxn, size_t i) {
+            sent = clock::now();
+            client.callAsync(cxn, RB{}.id(int(i)).method("mining.submit").param("0x1234").done(), [&, i] (CxnHandle cxn, Message res) {
+                report.latencies.push_back(clock::now() - sent);
+                if (i + 1 == count) {
+                    barrier.unblock();
+                    return;
+                }
+                submit(cxn, i + 1);
+            });
+        };
+
+        uint16_t port = launchStandInServer(server);
+
+        auto start = clock::now();
+        auto usage = Usage::now();
+        client.launchClient("127.0.0.1", port, [&] (CxnHandle cxn) {
+            client.setReadAsyncLoopEnabled(true);
+            client.readAsync(cxn);
+            submit(cxn, 0);
+        });
+
+        ASSERT_NE(barrier.wait_for(60s), std::future_status::timeout);
+        report.total = clock::now() - start;
+        report.usage = Usage::now() - usage;
+        report.client = client.getIOStats();
+        report.server = server.getIOStats();
+        report.print("pool round trips");
+    }
+
+    TEST(IOBackend, DISABLED_BenchmarkApiClients) {
+        //many monitoring clients poll the api concurrently
+
+        const size_t clientCount = 8;
+        const size_t callsPerClient = 2000;
+        Barrier barrier;
+        std::atomic_size_t done {0};
+        Report report;
+        report.messages = clientCount * callsPerClient;
+
+        JsonRpcUtil server{"bench api"};
+        server.addMethod("getGpuStats", [] () {
+            return nl::json{{"totalHashesPerSec", 31.2e6}, {"5sHashesPerSec", 30.9e6}, {"totalReports", 123456}};
+        });
+        uint16_t port = launchStandInServer(server);
+
+        std::vector<unique_ptr<JsonRpcUtil>> clients;
+        for (size_t c = 0; c < clientCount; ++c) {
+            clients.push_back(make_unique<JsonRpcUtil>("bench api client"));
+        }
+
+        auto start = clock::now();
+        auto usage = Usage::now();
+        for (auto &client : clients) {
+            //every client keeps one call in flight, like a polling monitoring script
+            auto poll = std::make_shared<std::function<void(CxnHandle, size_t)>>();
+            *poll = [&, poll = poll.get(), io = client.get()] (CxnHandle cxn, size_t i) {
+                io->callAsync(cxn, RB{}.id(int(i)).method("getGpuStats").done(), [&, poll, i] (CxnHandle cxn, Message res) {
+                    if (i + 1 < callsPerClient) {
+                        (*poll)(cxn, i + 1);
+                    }
+                    else if (++done == clientCount) {
+                        barrier.unblock();
+                    }
+                });
+            };
+
+            client->launchClient("127.0.0.1", port, [io = client.get(), poll] (CxnHandle cxn) {
+                io->setReadAsyncLoopEnabled(true);
+                io->readAsync(cxn);
+                (*poll)(cxn, 0);
+            });
+        }
+
+        ASSERT_NE(barrier.wait_for(60s), std::future_status::timeout);
+        report.total = clock::now() - start;
+        report.usage = Usage::now() - usage;
+        for (auto &client : clients) {
+            auto stats = client->getIOStats();
+            report.client.writeOps += stats.writeOps;
+            report.client.readOps += stats.readOps;
+        }
+        report.server = server.getIOStats();
+        report.print("api clients");
+    }
+
+}
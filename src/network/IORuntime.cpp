@@ -0,0 +1,94 @@
+//
+//
+
+#include "IORuntime.h"
+#include <src/util/Logging.h>
+#include <src/common/Assert.h>
+#include <mutex>
+
+namespace riner {
+
+    namespace {
+        std::mutex sharedMutex;
+        size_t sharedThreadCount = 0;
+        std::weak_ptr<IORuntime> sharedRuntime;
+
+        //the destructor joins the runtime's threads, so it must not run on one of them
+        void deleteRuntime(IORuntime *runtime) {
+            if (runtime->isOwnThread()) {
+                //the last user was destroyed by a handler of this runtime, hand the runtime off to another thread
+                std::thread([runtime] () {
+                    delete runtime;
+                }).detach();
+                return;
+            }
+            delete runtime;
+        }
+    }
+
+    void IORuntime::setSharedThreadCount(size_t threadCount) {
+        std::lock_guard<std::mutex> lock(sharedMutex);
+        sharedThreadCount = threadCount;
+    }
+
+    std::shared_ptr<IORuntime> IORuntime::getShared() {
+        std::lock_guard<std::mutex> lock(sharedMutex);
+        auto runtime = sharedRuntime.lock();
+        if (!runtime && sharedThreadCount > 0) {
+            runtime = std::shared_ptr<IORuntime>(new IORuntime(sharedThreadCount), deleteRuntime);
+            sharedRuntime = runtime;
+        }
+        return runtime;
+    }
+
+    const char *IORuntime::backendName() {
+#if defined(RINER_IO_URING)
+        return "io_uring"; //for socket reads and writes, see IoUring
+#elif defined(ASIO_HAS_EPOLL)
+        return "epoll";
+#elif defined(ASIO_HAS_KQUEUE)
+        return "kqueue";
+#elif defined(ASIO_HAS_IOCP)
+        return "iocp";
+#else
+        return "select";
+#endif
+    }
+
+    IORuntime::IORuntime(size_t threadCount)
+    : _work(make_unique<asio::io_service::work>(_ioService)) {
+        for (size_t i = 0; i < std::max(threadCount, size_t(1)); ++i) {
+            _threads.emplace_back([this, i] () {
+                SetThreadNameStream{} << "io runtime#" << i;
+
+                while (true) {
+                    try {
+                        _ioService.run(); //returns once _work is reset and no handlers are left
+                        break;
+                    }
+                    catch (std::exception &e) {
+                        LOG(ERROR) << "uncaught exception in io runtime thread: " << e.what();
+                    }
+                }
+            });
+        }
+        VLOG(3) << "io runtime started with " << _threads.size() << " threads";
+    }
+
+    bool IORuntime::isOwnThread() const {
+        for (auto &thread : _threads) {
+            if (thread.get_id() == std::this_thread::get_id())
+                return true;
+        }
+        return false;
+    }
+
+    IORuntime::~IORuntime() {
+        RNR_EXPECTS(!isOwnThread()); //joining itself would deadlock, see getShared() for how this is avoided
+        _work.reset();
+        for (auto &thread : _threads) {
+            thread.join();
+        }
+    }
+
+}
@@ -0,0 +1,66 @@
+//
+//
+#pragma once
+
+#include <asio.hpp>
+#include <src/common/Pointers.h>
+#include <src/util/Copy.h>
+#include <thread>
+#include <vector>
+
+namespace riner {
+
+    /**
+     * An `asio::io_service` that is run by a fixed number of threads and can be shared by many `BaseIO` objects.
+     * By default every `BaseIO` runs its own io thread. If a shared runtime is enabled via `setSharedThreadCount()`,
+     * `BaseIO` objects constructed afterwards use `getShared()` instead and serialize their handlers with a strand,
+     * so that the thread count does no longer grow with the number of pools/servers.
+     * Handlers should not block on other `BaseIO` objects (e.g. call their `disconnectAll()`) since every blocked
+     * handler occupies one of the runtime's threads.
+     */
+    class IORuntime {
+        asio::io_service _ioService;
+        unique_ptr<asio::io_service::work> _work; //keeps the threads running while no handlers are queued
+        std::vector<std::thread> _threads;
+
+    public:
+        explicit IORuntime(size_t threadCount);
+        ~IORuntime(); //joins the threads, must not be called on one of them. all BaseIO objects using this runtime must be destroyed before
+
+        DELETE_COPY_AND_MOVE(IORuntime);
+
+        asio::io_service &ioService() {
+            return _ioService;
+        }
+
+        size_t threadCount() const {
+            return _threads.size();
+        }
+
+        /**
+         * @return whether the calling thread is one of the threads that run this runtime
+         */
+        bool isOwnThread() const;
+
+        /**
+         * set the thread count of the runtime returned by `getShared()`. `0` (the default) disables the shared runtime,
+         * so that every `BaseIO` runs its own io thread. Must be called before the `BaseIO` objects that should use
+         * it are constructed, a runtime that is already in use keeps its thread count.
+         */
+        static void setSharedThreadCount(size_t threadCount);
+
+        /**
+         * @return the shared runtime, which is created on first use and lives as long as anybody holds it,
+         * or `nullptr` if the shared runtime is disabled. If its last holder is released on one of its threads,
+         * the runtime is destroyed on a separate thread
+         */
+        static std::shared_ptr<IORuntime> getShared();
+
+        /**
+         * @return the name of the mechanism that socket reads and writes go through, e.g. "epoll" or "io_uring" (if built
+         * with the cmake option RINER_IO_URING, see IoUring. falls back to asio's if the kernel doesn't support it)
+         */
+        static const char *backendName();
+    };
+
+}
@@ -5,6 +5,7 @@
 
 #include <functional>
 #include <string>
+#include <vector>
 #include <src/common/Chrono.h>
 #include <src/common/Pointers.h>
 #include <src/util/Logging.h>
@@ -30,6 +31,19 @@ namespace riner {
     inline void ioOnConnectedNoop(CxnHandle) {} //default argument for IOOnConnectedFunc
     inline void ioOnDisconnectedNoop() {};
 
+    /**
+     * traffic counters of an io object, summed over all of its connections
+     */
+    struct IOStats {
+        uint64_t messagesWritten = 0; //lines passed to writeAsync
+        uint64_t bytesWritten = 0;
+        uint64_t writeOps = 0; //socket writes, a single write can carry several queued messages
+        uint64_t bytesRead = 0;
+        uint64_t readOps = 0; //socket reads, a single read can contain several messages
+        uint64_t sslHandshakes = 0; //successful ones
+        uint64_t sslResumedSessions = 0; //handshakes that resumed a previous session instead of doing a full handshake
+    };
+
     /**
      * An IOConversionError should be thrown whenever an IOTypeLayer implementation fails to convert its argument in either its convertIncoming() or convertOutgoing() method.
      * For more details see std::runtime_error
@@ -221,6 +235,26 @@ namespace riner {
             }
         }
 
+        /**
+         * Same as `writeAsync(CxnHandle, T)` but sends all `ts` with a single socket write (in the given order), e.g.
+         * to coalesce several messages that became ready at the same time. Objects that fail to convert are skipped.
+         * @param cxn the connection handle to queue a write operation on
+         * @param ts the objects that get converted to the bottom most layer and then async-sent over the `cxn` together
+         */
+        void writeAsync(CxnHandle cxn, std::vector<T> ts) {
+            std::vector<LayerBelowT> lbts;
+            lbts.reserve(ts.size());
+            for (auto &t : ts) {
+                try {
+                    lbts.push_back(processOutgoing(std::move(t)));
+                }
+                catch(const IOConversionError &e) {
+                    LOG(WARNING) << "IOTypeLayer conversion failed on asyncWrite: " << e.what();
+                }
+            }
+            _layerBelow.writeAsync(cxn, std::move(lbts));
+        }
+
         /**
          * Enqueue an arbitrary function to run on the IO thread. For more details see boost::asio's `asio::post`.
          * @tparam Func functor with a `void operator()` that takes no arguments
@@ -242,6 +276,16 @@ namespace riner {
             _layerBelow.retryAsyncEvery(retryInterval, std::move(pred), std::move(onCancelled));
         }
 
+        /**
+         * run an arbitrary function on the IO thread once `time` has come. Unlike the retries of `retryAsyncEvery`, the
+         * function is not called if the io object is destroyed or all handlers are aborted (e.g. via disconnectAll) before.
+         * @param time the earliest time at which `func` is called
+         * @param func the function which is going to be executed on the io thread
+         */
+        void postAsyncAt(clock::time_point time, std::function<void()> func) {
+            _layerBelow.postAsyncAt(time, std::move(func));
+        }
+
         /**
          * `launchClient()` opens a single connection to the given host, port.
          * @param host host name or ip e.g. "localhost" or "127.0.0.1" to connect to
@@ -278,6 +322,14 @@ namespace riner {
             return layerBelow().hasLaunched();
         }
 
+        /**
+         * @return the port that `launchServer()` listens on, which is a free port chosen by the os if it was called with port 0.
+         * 0 if no server was launched. this function can be called from any thread
+         */
+        uint16_t serverPort() const {
+            return _layerBelow.serverPort();
+        }
+
         /**
          * check whether the calling thread is the io thread. this function can be called from any thread
          * @return `true` if the calling thread is the io thread owned by this object, `false` otherwise
@@ -290,6 +342,13 @@ namespace riner {
             return layerBelow().disconnectAll();
         }
 
+        /**
+         * @return traffic counters of all connections of this io object. this function can be called from any thread
+         */
+        IOStats getIOStats() const {
+            return _layerBelow.getIOStats();
+        }
+
     protected:
         /**
          * call this function in the dtor of your `IOTypeLayer` subclasses.
@@ -310,6 +369,47 @@ namespace riner {
             return _layerBelow.ioThreadRunning();
         }
 
+        /**
+         * Same as `setOnReceive()`, but the values arriving two layers below are first offered to `shortcut`, which may
+         * convert them to a `T` directly instead of going through the layer below and this layer's `convertIncoming()`.
+         * If `shortcut` returns `false`, or if the layer below has an incoming modifier set (which must see its type),
+         * the value takes the regular path. This layer's incoming modifier is applied in both cases.
+         * @param shortcut functor `bool(const LayerBelow::LayerBelowT &, T &)` that returns whether it assigned the `T`
+         */
+        template<class Shortcut>
+        void setOnReceiveWithShortcut(OnReceiveValueFunc &&onRecv, Shortcut &&shortcut) {
+            checkNotLaunchedOrOnIOThread();
+            using LayerBelowBelowT = typename LayerBelow::LayerBelowT;
+
+            _layerBelow._layerBelow.setOnReceive([this, onRecv = std::move(onRecv), shortcut = std::forward<Shortcut>(shortcut)]
+                    (CxnHandle cxn, LayerBelowBelowT lbbt) {
+                try {
+                    T t;
+                    if (!_layerBelow._incomingModifier && shortcut(lbbt, t)) {
+                        if (_incomingModifier)
+                            _incomingModifier(t);
+                    }
+                    else {
+                        t = processIncoming(_layerBelow.processIncoming(std::move(lbbt)));
+                    }
+                    onRecv(cxn, std::move(t));
+                }
+                catch(const IOConversionError &e) {
+                    LOG(WARNING) << "IOTypeLayer conversion failed on receive: " << e.what();
+                }
+            });
+        }
+
+        /**
+         * converts `t` two layers down, with the same outgoing modifiers and conversions that `writeAsync()` applies.
+         * Useful to send `T`s together with values that already have that type (e.g. preformatted lines) in a
+         * single write on the layer below's layer below, without changing their order.
+         * This function may throw an `IOConversionError` if the conversion failed.
+         */
+        auto processOutgoingTwoLayersDown(T t) { //returns a LayerBelow::LayerBelowT
+            return _layerBelow.processOutgoing(processOutgoing(std::move(t)));
+        }
+
         /**
          * shorthand for ensuring that it is ok to mutate the layer's state
          */
@@ -0,0 +1,312 @@
+//
+//
+
+#ifdef RINER_IO_URING
+
+#include "IoUring.h"
+#include <src/util/Logging.h>
+#include <src/common/Assert.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <atomic>
+#include <cstring>
+
+namespace riner {
+
+    namespace {
+        constexpr unsigned queueDepth = 256; //submission queue entries, the completion queue is twice as large
+
+        void warnUnavailable(const char *what, int error) {
+            static std::atomic_bool warned {false};
+            if (!warned.exchange(true)) {
+                LOG(WARNING) << "io_uring is not available (" << what << ": " << strerror(error) << "), using asio for socket reads and writes instead";
+            }
+        }
+    }
+
+    struct IoUring::Operation {
+        int fd = -1;
+        bool isSend = false;
+        bool polling = false; //waiting for the socket to become ready, because the kernel returned EAGAIN
+        bool cancelled = false;
+        Handler handler;
+        asio::mutable_buffer recvBuffer;
+        std::vector<iovec> sendBuffers; //the part that is not sent yet starts at sendBegin
+        size_t sendBegin = 0;
+        msghdr msg {};
+        size_t numBytes = 0; //transferred so far
+    };
+
+    unique_ptr<IoUring> IoUring::tryCreate(asio::io_service &ioService, PostFunc post) {
+        unique_ptr<IoUring> ring{new IoUring(ioService, std::move(post))};
+
+        int result = io_uring_queue_init(queueDepth, &ring->_ring, 0);
+        if (result < 0) {
+            warnUnavailable("io_uring_queue_init", -result);
+            return nullptr;
+        }
+        ring->_ringInitialized = true;
+
+        int eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (eventFd < 0) {
+            warnUnavailable("eventfd", errno);
+            return nullptr;
+        }
+        ring->_eventFd.assign(eventFd); //closes it from now on
+
+        result = io_uring_register_eventfd(&ring->_ring, eventFd);
+        if (result < 0) {
+            warnUnavailable("io_uring_register_eventfd", -result);
+            return nullptr;
+        }
+        return ring;
+    }
+
+    IoUring::IoUring(asio::io_service &ioService, PostFunc post)
+    : _eventFd(ioService)
+    , _post(std::move(post)) {
+    }
+
+    IoUring::~IoUring() {
+        close();
+        if (_ringInitialized) {
+            io_uring_queue_exit(&_ring);
+        }
+    }
+
+    void IoUring::asyncRecv(int fd, asio::mutable_buffer buffer, Handler handler) {
+        if (_closed) {
+            return; //handler is dropped, like the handlers of a stopped io_service
+        }
+        auto op = make_unique<Operation>();
+        op->fd = fd;
+        op->handler = std::move(handler);
+        op->recvBuffer = buffer;
+
+        auto &ref = *op;
+        _operations.emplace(&ref, std::move(op));
+        prepare(ref);
+    }
+
+    void IoUring::asyncSend(int fd, const std::vector<asio::const_buffer> &buffers, Handler handler) {
+        if (_closed) {
+            return; //handler is dropped, like the handlers of a stopped io_service
+        }
+        auto op = make_unique<Operation>();
+        op->fd = fd;
+        op->isSend = true;
+        op->handler = std::move(handler);
+        for (auto &buffer : buffers) {
+            if (buffer.size() > 0) {
+                op->sendBuffers.push_back({const_cast<void *>(buffer.data()), buffer.size()});
+            }
+        }
+        if (op->sendBuffers.empty()) {
+            _post([handler = std::move(op->handler)] () {
+                handler({}, 0);
+            });
+            return;
+        }
+
+        auto &ref = *op;
+        _operations.emplace(&ref, std::move(op));
+        prepare(ref);
+    }
+
+    void IoUring::cancel(int fd) {
+        if (_closed) {
+            return;
+        }
+        for (auto &entry : _operations) {
+            auto &op = *entry.second;
+            if (op.fd != fd || op.cancelled) {
+                continue;
+            }
+            op.cancelled = true;
+            auto sqe = getSqe();
+            io_uring_prep_cancel(sqe, &op, 0);
+            io_uring_sqe_set_data(sqe, nullptr); //the completion of the cancel request itself is ignored
+        }
+        if (_unsubmitted) {
+            submit(); //right away, since fd is about to be closed (and may be reused) while operations are queued on it
+        }
+    }
+
+    void IoUring::dispatchCompletions() {
+        _dispatching = true;
+        try {
+            io_uring_cqe *cqe = nullptr;
+            while (!_closed && io_uring_peek_cqe(&_ring, &cqe) == 0) {
+                auto op = static_cast<Operation *>(io_uring_cqe_get_data(cqe));
+                int result = cqe->res;
+                io_uring_cqe_seen(&_ring, cqe);
+                if (op) { //nullptr for cancel requests
+                    complete(*op, result);
+                }
+            }
+        }
+        catch (...) {
+            _dispatching = false;
+            throw;
+        }
+        _dispatching = false;
+
+        //one io_uring_enter for all reads and writes that were issued by the handlers
+        if (_unsubmitted && !_closed) {
+            submit();
+        }
+    }
+
+    void IoUring::close() {
+        if (_closed) {
+            return;
+        }
+        _closed = true;
+
+        if (_ringInitialized && !_operations.empty()) {
+            for (auto &entry : _operations) {
+                auto &op = *entry.second;
+                if (!op.cancelled) {
+                    op.cancelled = true;
+                    auto sqe = getSqe();
+                    io_uring_prep_cancel(sqe, &op, 0);
+                    io_uring_sqe_set_data(sqe, nullptr);
+                }
+            }
+            io_uring_submit(&_ring);
+
+            //the kernel may still write into the operations' buffers until they have completed
+            while (!_operations.empty()) {
+                io_uring_cqe *cqe = nullptr;
+                int result = io_uring_wait_cqe(&_ring, &cqe);
+                if (result < 0) {
+                    LOG(ERROR) << "io_uring_wait_cqe failed while closing (" << strerror(-result) << "), leaking " << _operations.size() << " operations";
+                    for (auto &entry : _operations) {
+                        entry.second.release(); //their buffers may still be in use
+                    }
+                    _operations.clear();
+                    break;
+                }
+                auto op = static_cast<Operation *>(io_uring_cqe_get_data(cqe));
+                io_uring_cqe_seen(&_ring, cqe);
+
+                auto it = _operations.find(op);
+                if (it != _operations.end()) {
+                    auto dropped = std::move(it->second);
+                    _operations.erase(it);
+                } //its handler is destroyed here without being called
+            }
+        }
+
+        asio::error_code ignored;
+        _eventFd.close(ignored);
+    }
+
+    void IoUring::prepare(Operation &op) {
+        auto sqe = getSqe();
+        if (op.polling) {
+            io_uring_prep_poll_add(sqe, op.fd, op.isSend ? POLLOUT : POLLIN);
+        }
+        else if (op.isSend) {
+            op.msg.msg_iov = op.sendBuffers.data() + op.sendBegin;
+            op.msg.msg_iovlen = op.sendBuffers.size() - op.sendBegin;
+            io_uring_prep_sendmsg(sqe, op.fd, &op.msg, MSG_NOSIGNAL);
+        }
+        else {
+            io_uring_prep_recv(sqe, op.fd, op.recvBuffer.data(), op.recvBuffer.size(), 0);
+        }
+        io_uring_sqe_set_data(sqe, &op);
+        submitSoon();
+    }
+
+    void IoUring::complete(Operation &op, int result) {
+        asio::error_code error;
+        bool retry = false;
+
+        if (op.cancelled && result < 0) {
+            error = asio::error::operation_aborted;
+        }
+        else if (result == -EAGAIN && !op.polling) {
+            op.polling = true; //the socket is non-blocking (set by asio) and some kernels don't wait for it then
+            retry = true;
+        }
+        else if (result < 0) {
+            error = asio::error_code(-result, asio::error::get_system_category());
+        }
+        else if (op.polling) {
+            op.polling = false; //ready now
+            retry = true;
+        }
+        else if (!op.isSend) {
+            op.numBytes = size_t(result);
+            if (result == 0) {
+                error = asio::error::eof;
+            }
+        }
+        else {
+            op.numBytes += size_t(result);
+            size_t sent = size_t(result);
+            while (sent > 0) {
+                auto &buffer = op.sendBuffers[op.sendBegin];
+                if (sent < buffer.iov_len) {
+                    buffer.iov_base = static_cast<char *>(buffer.iov_base) + sent;
+                    buffer.iov_len -= sent;
+                    break;
+                }
+                sent -= buffer.iov_len;
+                ++op.sendBegin;
+            }
+            retry = op.sendBegin < op.sendBuffers.size(); //partial send, send the rest
+        }
+
+        if (retry) {
+            if (!op.cancelled) {
+                prepare(op);
+                return;
+            }
+            error = asio::error::operation_aborted;
+        }
+
+        auto it = _operations.find(&op);
+        RNR_EXPECTS(it != _operations.end());
+        auto done = std::move(it->second);
+        _operations.erase(it);
+        done->handler(error, done->numBytes);
+    }
+
+    io_uring_sqe *IoUring::getSqe() {
+        auto sqe = io_uring_get_sqe(&_ring);
+        if (!sqe) {
+            submit(); //submission queue is full
+            sqe = io_uring_get_sqe(&_ring);
+        }
+        RNR_ENSURES(sqe);
+        _unsubmitted = true;
+        return sqe;
+    }
+
+    void IoUring::submitSoon() {
+        if (_dispatching || _submitPosted) {
+            return; //dispatchCompletions() or the posted function will submit
+        }
+        _submitPosted = true;
+        //operations that are issued until then (e.g. writes of several posted handlers) are submitted together
+        _post([this] () {
+            _submitPosted = false;
+            if (_unsubmitted && !_closed) {
+                submit();
+            }
+        });
+    }
+
+    void IoUring::submit() {
+        _unsubmitted = false;
+        int result = io_uring_submit(&_ring);
+        if (result < 0) {
+            LOG(ERROR) << "io_uring_submit failed: " << strerror(-result);
+        }
+    }
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+//
+//
+#pragma once
+
+#ifdef RINER_IO_URING
+
+#include <asio.hpp>
+#include <src/common/Pointers.h>
+#include <src/util/Copy.h>
+#include <liburing.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace riner {
+
+    /**
+     * Thin io_uring backend for the reads and writes of plain tcp sockets (see `Socket`), used if built with the cmake
+     * option RINER_IO_URING. Everything else (connect, accept, resolve, ssl sockets, timers) is still done by asio's
+     * default reactor.
+     * Reads and writes that are issued while completions are dispatched (e.g. the next read of every connection that
+     * received data and the responses its handlers write) are submitted together with a single `io_uring_enter` call.
+     * Completions are signalled through an eventfd which is waited on with asio.
+     * Every `BaseIO` owns one ring. Not thread safe, all functions must be called on the io thread (or strand) of
+     * that `BaseIO`.
+     */
+    class IoUring {
+    public:
+        using Handler = std::function<void(const asio::error_code &, size_t numBytes)>;
+        using PostFunc = std::function<void(std::function<void()>)>;
+
+        /**
+         * @param post runs a function on the io thread later. used to submit the operations that are not issued while
+         * completions are dispatched
+         * @return nullptr if io_uring is not available (e.g. old kernel or blocked by seccomp), in which case asio
+         * should be used for the reads and writes as well
+         */
+        static unique_ptr<IoUring> tryCreate(asio::io_service &, PostFunc post);
+        ~IoUring(); //calls close()
+
+        DELETE_COPY_AND_MOVE(IoUring);
+
+        /**
+         * receives whatever is available (at least one byte) into buffer, see asio's `async_read_some`
+         */
+        void asyncRecv(int fd, asio::mutable_buffer buffer, Handler handler);
+
+        /**
+         * sends all buffers, see asio's `async_write`
+         */
+        void asyncSend(int fd, const std::vector<asio::const_buffer> &buffers, Handler handler);
+
+        /**
+         * makes the pending operations of fd complete with asio::error::operation_aborted. must be called before fd
+         * gets closed, since the operations may not have been submitted yet
+         */
+        void cancel(int fd);
+
+        /**
+         * calls handler (via asio) as soon as completions are available. handler should then call
+         * dispatchCompletions() and wait again
+         */
+        template<class WaitHandler>
+        void asyncWaitForCompletions(WaitHandler &&handler) {
+            _eventFd.async_read_some(asio::buffer(&_eventCount, sizeof(_eventCount)), std::forward<WaitHandler>(handler));
+        }
+
+        /**
+         * calls the handlers of all completed operations, then submits the operations they issued
+         */
+        void dispatchCompletions();
+
+        /**
+         * aborts all pending operations and destroys their handlers without calling them, the handler of
+         * asyncWaitForCompletions completes with an error. blocks until the kernel is done with the operations' buffers.
+         * operations that are issued afterwards are dropped
+         */
+        void close();
+
+    private:
+        struct Operation;
+
+        IoUring(asio::io_service &, PostFunc post);
+
+        io_uring _ring {};
+        bool _ringInitialized = false;
+        asio::posix::stream_descriptor _eventFd;
+        uint64_t _eventCount = 0;
+        PostFunc _post;
+        std::unordered_map<Operation *, unique_ptr<Operation>> _operations; //not completed yet, keyed by their user_data
+        bool _dispatching = false; //whether dispatchCompletions() is running, it submits when it is done
+        bool _unsubmitted = false; //whether operations were prepared but not submitted yet
+        bool _submitPosted = false;
+        bool _closed = false;
+
+        void prepare(Operation &);
+        void complete(Operation &, int result);
+        io_uring_sqe *getSqe();
+        void submitSoon();
+        void submit();
+    };
+
+}
+
+#endif
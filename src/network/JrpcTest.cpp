@@ -1,8 +1,12 @@
 
 #include <src/network/JsonRpcBuilder.h>
 #include <src/network/JsonRpcUtil.h>
+#include <src/network/LineIO.h>
 
 #include <future>
+#include <thread>
+#include <fstream>
+#include <sstream>
 #include <src/util/Barrier.h>
 
 #include <gtest/gtest.h>
@@ -309,6 +313,205 @@ namespace riner {
         }
     };
 
+    //same as JsonRpcServerClientFixture, but server and client run on a shared IORuntime instead of their own io threads
+    class JsonRpcSharedRuntimeFixture : public JsonRpcServerClientFixture {
+    public:
+        JsonRpcSharedRuntimeFixture() {
+            IORuntime::setSharedThreadCount(2);
+            server = make_unique<JsonRpcUtil>();
+            client = make_unique<JsonRpcUtil>();
+            IORuntime::setSharedThreadCount(0); //the runtime lives on as long as server or client are using it
+        }
+    };
+
+    TEST_F(JsonRpcSharedRuntimeFixture, CallsAndReconnect) {
+        //this test makes calls over an ssl connection, then disconnects the client and makes them again after relaunching it
+
+        const int count = 20;
+        std::atomic_int responded {0};
+        std::atomic_int connected {0};
+        Barrier secondRound;
+
+        EXPECT_TRUE(initSsl());
+
+        server->addMethod("double", [&] (int n) {
+            return 2 * n;
+        }, "n");
+
+        auto onConnected = [&] (CxnHandle cxn) {
+            ++connected;
+            for (int n = 0; n < count; ++n) {
+                client->callAsync(cxn, RB{}.id(n).method("double").param("n", n).done(), [&, n] (CxnHandle cxn, Message res) {
+                    EXPECT_EQ(res.getIfResult()->get<int>(), 2 * n);
+                    int r = ++responded;
+                    if (r == count) {
+                        barrier.unblock();
+                    }
+                    else if (r == 2 * count) {
+                        secondRound.unblock();
+                    }
+                });
+            }
+            client->setReadAsyncLoopEnabled(true);
+            client->readAsync(cxn);
+        };
+
+        launchServerWithReadLoop();
+        launchClient(onConnected);
+
+        bool timeout = waitAndInvoke(barrier, [&] () {
+            EXPECT_EQ(responded, count);
+            client->io().disconnectAll(); //stops and restarts the client without touching the server's handlers
+            launchClient(onConnected);
+        });
+        EXPECT_FALSE(timeout);
+
+        timeout = waitAndInvoke(secondRound, [&] () {
+            server.reset();
+            client.reset();
+            EXPECT_EQ(responded, 2 * count);
+            EXPECT_EQ(connected, 2);
+            EXPECT_EQ(IORuntime::getShared(), nullptr); //destroyed together with its last user
+        }, 4s);
+        EXPECT_FALSE(timeout);
+    }
+
+    TEST(JsonRpcSharedRuntime, ReconnectWaitDoesNotBlockRuntime) {
+        //a client that keeps failing to reconnect waits >= 10s between tries, which must not occupy the only thread
+        //of the runtime that the other io objects are running on
+
+        IORuntime::setSharedThreadCount(1);
+        JsonRpcUtil dead{"dead pool"};
+        JsonRpcUtil server;
+        JsonRpcUtil client;
+        IORuntime::setSharedThreadCount(0);
+
+        Barrier failed;
+        Barrier responded;
+        std::atomic_bool failedOnce {false};
+
+        dead.launchClientAutoReconnect("127.0.0.1", 4032, ioOnConnectedNoop, [&] () {
+            if (!failedOnce.exchange(true))
+                failed.unblock();
+        });
+        ASSERT_NE(failed.wait_for(2s), std::future_status::timeout); //nothing is listening on that port
+
+        server.addMethod("ping", [] () {
+            return true;
+        });
+        server.launchServer(4031, [&] (CxnHandle cxn) {
+            server.setReadAsyncLoopEnabled(true);
+            server.readAsync(cxn);
+        });
+        client.launchClient("127.0.0.1", 4031, [&] (CxnHandle cxn) {
+            client.setReadAsyncLoopEnabled(true);
+            client.readAsync(cxn);
+            client.callAsync(cxn, RequestBuilder{}.id(1).method("ping").done(), [&] (CxnHandle, Message res) {
+                responded.unblock();
+            });
+        });
+
+        EXPECT_NE(responded.wait_for(2s), std::future_status::timeout);
+    }
+
+    TEST(JsonRpcSharedRuntime, ReleasedOnOwnThread) {
+        //if the last holder of a runtime lets go of it on one of the runtime's threads, the runtime must not join
+        //that thread (or wait for it while it's still running the handler)
+
+        IORuntime::setSharedThreadCount(2);
+        auto runtime = IORuntime::getShared();
+        IORuntime::setSharedThreadCount(0);
+        ASSERT_TRUE(runtime);
+
+        Barrier released;
+        auto &ioService = runtime->ioService();
+        ioService.post([runtime = std::move(runtime), &released] () mutable {
+            runtime.reset(); //the runtime is destroyed on another thread
+            released.unblock();
+        });
+
+        EXPECT_NE(released.wait_for(2s), std::future_status::timeout);
+    }
+
+#ifdef __linux__
+    namespace {
+        //number of sockets on this machine that are waiting for an answer to their connection attempt to the given port
+        //(SYN_SENT)
+        int connectingSocketsTo(uint16_t port) {
+            std::ifstream file{"/proc/net/tcp"};
+            std::string line;
+            std::getline(file, line); //header
+            int count = 0;
+            while (std::getline(file, line)) {
+                std::istringstream fields{line};
+                std::string slot, local, remote, state;
+                fields >> slot >> local >> remote >> state;
+                auto colon = remote.find(':');
+                if (state == "02" && colon != std::string::npos && std::stoul(remote.substr(colon + 1), nullptr, 16) == port)
+                    ++count;
+            }
+            return count;
+        }
+    }
+#endif
+
+    TEST(BaseIO, InterleaveAddressFamilies) {
+        using tcp = asio::ip::tcp;
+        auto ep = [] (const char *address) {
+            return tcp::endpoint{asio::ip::make_address(address), 4029};
+        };
+        using Endpoints = std::vector<tcp::endpoint>;
+
+        EXPECT_EQ(BaseIO::interleaveAddressFamilies({ep("::1"), ep("::2"), ep("::3"), ep("10.0.0.1")}),
+                  (Endpoints{ep("::1"), ep("10.0.0.1"), ep("::2"), ep("::3")}));
+        EXPECT_EQ(BaseIO::interleaveAddressFamilies({ep("10.0.0.1"), ep("10.0.0.2"), ep("::1"), ep("::2")}),
+                  (Endpoints{ep("10.0.0.1"), ep("::1"), ep("10.0.0.2"), ep("::2")}));
+        EXPECT_EQ(BaseIO::interleaveAddressFamilies({ep("10.0.0.2"), ep("10.0.0.1")}),
+                  (Endpoints{ep("10.0.0.2"), ep("10.0.0.1")}));
+        EXPECT_EQ(BaseIO::interleaveAddressFamilies({}), Endpoints{});
+    }
+
+#ifdef __linux__ //needs /proc/net/tcp and the blackhole behavior of linux
+    TEST(BaseIO, StaggeredConnectSkipsBlackholedEndpoint) {
+        //the first endpoint never answers, so the client must start an attempt to the second one after
+        //connectAttemptDelay and close the pending attempt to the first one once the second one succeeded
+        using tcp = asio::ip::tcp;
+
+        //on linux a listener with a full accept queue silently drops further connection attempts
+        asio::io_service blackholeService;
+        tcp::acceptor blackhole{blackholeService};
+        blackhole.open(tcp::v4());
+        blackhole.bind({asio::ip::make_address("127.0.0.1"), 0});
+        blackhole.listen(0);
+        tcp::socket queued{blackholeService};
+        queued.connect(blackhole.local_endpoint()); //fills the accept queue
+        uint16_t blackholePort = blackhole.local_endpoint().port();
+
+        LineIO server;
+        server.launchServer(0, [&] (CxnHandle cxn) {
+            server.readAsync(cxn);
+        });
+
+        Barrier connected;
+        clock::time_point connectedTime;
+        LineIO client;
+        auto start = clock::now();
+        client.layerBelow().launchClient({blackhole.local_endpoint(), {asio::ip::make_address("127.0.0.1"), server.serverPort()}}, [&] (CxnHandle cxn) {
+            connectedTime = clock::now();
+            connected.unblock();
+        });
+
+        std::this_thread::sleep_for(BaseIO::connectAttemptDelay / 2);
+        EXPECT_EQ(connectingSocketsTo(blackholePort), 1);
+
+        //without the staggered attempt it would only connect after the blackholed attempt timed out (minutes)
+        ASSERT_NE(connected.wait_for(10s), std::future_status::timeout);
+        EXPECT_GE(connectedTime - start, BaseIO::connectAttemptDelay);
+
+        EXPECT_EQ(connectingSocketsTo(blackholePort), 0); //the losing attempt was closed
+    }
+#endif
+
     TEST_F(JsonRpcServerClientFixture, MethodNotFound) {
         //this test calls a function that the server does not offer
 
@@ -340,6 +543,234 @@ namespace riner {
         EXPECT_FALSE(timeout);
     }
 
+    TEST_F(JsonRpcServerClientFixture, BatchedCallsWithRetries) {
+        //this test sends several calls with a single write and expects every call to get its own response
+
+        LockGuarded<std::vector<int>> received; //in the order the server received them
+        LockGuarded<std::map<int64_t, int>> results; //result per request id
+
+        server->addMethod("double", [&] (int n) {
+            received.lock()->push_back(n);
+            return 2 * n;
+        }, "n");
+
+        launchServerWithReadLoop();
+        launchClient([&] (CxnHandle cxn) {
+            std::vector<JsonRpcUtil::RetriedCall> calls;
+            for (int n = 1; n <= 3; ++n) {
+                JsonRpcUtil::RetriedCall call;
+                call.request = RB{}.id(n).method("double").param("n", n).done();
+                call.handler = [&] (CxnHandle cxn, Message res) {
+                    auto lresults = results.lock();
+                    (*lresults)[res.id.get<int64_t>()] = res.getIfResult()->get<int>();
+                    if (lresults->size() == 3) {
+                        barrier.unblock();
+                    }
+                };
+                calls.push_back(std::move(call));
+            }
+            client->callAsyncRetryNTimes(cxn, std::move(calls), 3, 10s);
+            client->setReadAsyncLoopEnabled(true);
+            client->readAsync(cxn);
+        });
+
+        bool timeout = waitAndInvoke(barrier, [&] () {
+            auto stats = client->getIOStats();
+            server.reset();
+            client.reset();
+
+            EXPECT_EQ(*received.lock(), std::vector<int>({1, 2, 3}));
+            std::map<int64_t, int> expected {{1, 2}, {2, 4}, {3, 6}};
+            EXPECT_EQ(*results.lock(), expected);
+            EXPECT_EQ(stats.messagesWritten, 3);
+            EXPECT_EQ(stats.writeOps, 1);
+        });
+        EXPECT_FALSE(timeout);
+    }
+
+    TEST_F(JsonRpcServerClientFixture, BatchedPreformattedLines) {
+        //calls whose request was rendered by a RequestLineWriter are sent as is and tracked by request.id,
+        //a batch that mixes them with regular calls is sent in the given order
+
+        LockGuarded<std::vector<int>> received; //in the order the server received them
+        LockGuarded<std::map<int64_t, int>> results;
+
+        server->addMethod("double", [&] (int n) {
+            received.lock()->push_back(n);
+            return 2 * n;
+        }, "n");
+
+        launchServerWithReadLoop();
+        launchClient([&] (CxnHandle cxn) {
+            RequestLineWriter writer;
+            std::vector<JsonRpcUtil::RetriedCall> calls;
+            for (int n = 1; n <= 3; ++n) {
+                JsonRpcUtil::RetriedCall call;
+                if (n == 2) {
+                    call.request = RB{}.id(n).method("double").param("n", n).done();
+                }
+                else {
+                    call.request = RB{}.id(n).method("double").done();
+                    call.line = writer.id(n).method("double").param("n", int64_t(n)).done();
+                }
+                call.handler = [&] (CxnHandle cxn, Message res) {
+                    auto lresults = results.lock();
+                    (*lresults)[res.id.get<int64_t>()] = res.getIfResult()->get<int>();
+                    if (lresults->size() == 3) {
+                        barrier.unblock();
+                    }
+                };
+                calls.push_back(std::move(call));
+            }
+            client->callAsyncRetryNTimes(cxn, std::move(calls), 3, 10s);
+            client->setReadAsyncLoopEnabled(true);
+            client->readAsync(cxn);
+        });
+
+        bool timeout = waitAndInvoke(barrier, [&] () {
+            auto stats = client->getIOStats();
+            server.reset();
+            client.reset();
+
+            EXPECT_EQ(*received.lock(), std::vector<int>({1, 2, 3}));
+            std::map<int64_t, int> expected {{1, 2}, {2, 4}, {3, 6}};
+            EXPECT_EQ(*results.lock(), expected);
+            EXPECT_EQ(stats.writeOps, 1);
+        });
+        EXPECT_FALSE(timeout);
+    }
+
+    TEST_F(JsonRpcServerClientFixture, WritesQueuedDuringWriteAreGathered) {
+        //calls made while a write is in progress are queued and sent together with the next write
+
+        const int count = 20;
+        std::atomic_int responded {0};
+
+        server->addMethod("double", [&] (int n) {
+            return 2 * n;
+        }, "n");
+
+        launchServerWithReadLoop();
+        launchClient([&] (CxnHandle cxn) {
+            for (int n = 0; n < count; ++n) {
+                client->callAsync(cxn, RB{}.id(n).method("double").param("n", n).done(), [&, n] (CxnHandle cxn, Message res) {
+                    EXPECT_EQ(res.getIfResult()->get<int>(), 2 * n);
+                    if (++responded == count) {
+                        barrier.unblock();
+                    }
+                });
+            }
+            client->setReadAsyncLoopEnabled(true);
+            client->readAsync(cxn);
+        });
+
+        bool timeout = waitAndInvoke(barrier, [&] () {
+            auto stats = client->getIOStats();
+            server.reset();
+            client.reset();
+
+            EXPECT_EQ(stats.messagesWritten, count);
+            EXPECT_LT(stats.writeOps, stats.messagesWritten);
+            EXPECT_GT(stats.bytesWritten, 0);
+            EXPECT_GT(stats.bytesRead, 0);
+            EXPECT_GE(stats.readOps, 1);
+        });
+        EXPECT_FALSE(timeout);
+    }
+
+    TEST_F(JsonRpcServerClientFixture, CallsFromOtherThreads) {
+        //calls can be made from any thread, their writes are posted to the io thread which owns the write queue
+
+        const int threadCount = 4;
+        const int callsPerThread = 50;
+        std::atomic_int responded {0};
+        Barrier connected;
+        optional<CxnHandle> clientCxn;
+
+        server->addMethod("double", [&] (int n) {
+            return 2 * n;
+        }, "n");
+
+        launchServerWithReadLoop();
+        launchClient([&] (CxnHandle cxn) {
+            client->setReadAsyncLoopEnabled(true);
+            client->readAsync(cxn);
+            clientCxn = cxn;
+            connected.unblock();
+        });
+        ASSERT_NE(connected.wait_for(2s), std::future_status::timeout);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&, t] () {
+                for (int i = 0; i < callsPerThread; ++i) {
+                    int n = t * callsPerThread + i;
+                    client->callAsync(*clientCxn, RB{}.id(n).method("double").param("n", n).done(), [&, n] (CxnHandle cxn, Message res) {
+                        EXPECT_EQ(res.getIfResult()->get<int>(), 2 * n);
+                        if (++responded == threadCount * callsPerThread) {
+                            barrier.unblock();
+                        }
+                    });
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        bool timeout = waitAndInvoke(barrier, [&] () {
+            EXPECT_EQ(client->getIOStats().messagesWritten, threadCount * callsPerThread);
+            server.reset();
+            client.reset();
+        });
+        EXPECT_FALSE(timeout);
+    }
+
+    TEST_F(JsonRpcServerClientFixture, BurstOfLongLines) {
+        //this test sends many lines at once, some of them longer than the connection's initial read buffer,
+        //so that reads end in the middle of lines and single reads contain several lines
+
+        const int count = 50;
+        std::atomic_int received {0};
+        std::atomic_int responded {0};
+
+        server->addMethod("echo", [&] (std::string text) {
+            ++received;
+            return text;
+        }, "text");
+
+        auto textFor = [] (int n) {
+            return std::string(size_t(n % 3 == 0 ? 10000 : 10), char('a' + n % 26));
+        };
+
+        launchServerWithReadLoop();
+        launchClient([&] (CxnHandle cxn) {
+            std::vector<JsonRpcUtil::RetriedCall> calls;
+            for (int n = 0; n < count; ++n) {
+                JsonRpcUtil::RetriedCall call;
+                call.request = RB{}.id(n).method("echo").param("text", textFor(n)).done();
+                call.handler = [&, n] (CxnHandle cxn, Message res) {
+                    EXPECT_EQ(res.getIfResult()->get<std::string>(), textFor(n));
+                    if (++responded == count) {
+                        barrier.unblock();
+                    }
+                };
+                calls.push_back(std::move(call));
+            }
+            client->callAsyncRetryNTimes(cxn, std::move(calls), 1, 10s);
+            client->setReadAsyncLoopEnabled(true);
+            client->readAsync(cxn);
+        });
+
+        bool timeout = waitAndInvoke(barrier, [&] () {
+            server.reset();
+            client.reset();
+        });
+        EXPECT_FALSE(timeout);
+        EXPECT_EQ(received, count);
+        EXPECT_EQ(responded, count);
+    }
+
     TEST_F(JsonRpcServerClientFixture, SslConnection) {
         //this test calls a jrpc on an ssl enabled io object
         //it does not test whether the ssl stream actually works!
@@ -378,6 +809,55 @@ namespace riner {
         EXPECT_FALSE(timeout);
     }
 
+    TEST_F(JsonRpcServerClientFixture, SslReconnectResumesSession) {
+        //this test connects twice with the same client and expects the second handshake to resume the first session
+
+#ifndef HAS_OPENSSL
+        LOG(INFO) << "skip this test since the binary was compiled without openssl support";
+        return;
+#endif
+
+        std::atomic_int responded {0};
+        Barrier secondRound;
+
+        EXPECT_TRUE(initSsl());
+
+        server->addMethod("method", [] () {
+            return true;
+        });
+
+        auto onConnected = [&] (CxnHandle cxn) {
+            client->callAsync(cxn, RB{}.id(0).method("method").done(), [&] (CxnHandle cxn, Message res) {
+                EXPECT_TRUE(res.isResultTrue());
+                (++responded == 1 ? barrier : secondRound).unblock();
+            });
+            client->setReadAsyncLoopEnabled(true);
+            client->readAsync(cxn);
+        };
+
+        launchServerWithReadLoop();
+        launchClient(onConnected);
+
+        bool timeout = waitAndInvoke(barrier, [&] () {
+            client->io().disconnectAll();
+            launchClient(onConnected);
+        });
+        EXPECT_FALSE(timeout);
+
+        timeout = waitAndInvoke(secondRound, [&] () {
+            auto clientStats = client->getIOStats();
+            auto serverStats = server->getIOStats();
+            server.reset();
+            client.reset();
+
+            EXPECT_EQ(clientStats.sslHandshakes, 2);
+            EXPECT_EQ(clientStats.sslResumedSessions, 1);
+            EXPECT_EQ(serverStats.sslHandshakes, 2);
+            EXPECT_EQ(serverStats.sslResumedSessions, 1);
+        });
+        EXPECT_FALSE(timeout);
+    }
+
     TEST_F(JsonRpcServerClientFixture, SslHandshakeWrongPassword) {
         //this test tries to call a jrpc on an ssl enabled io object with a wrong password
         //it tests whether no connection is established with a wrong password
@@ -566,6 +1046,40 @@ namespace riner {
         EXPECT_FALSE(timeout);
     }
 
+    TEST_F(JsonRpcServerClientFixture, RoundTripsOfResentCallsAreNotMeasured) {
+        //the response to a resent call may answer any of its tries, so its round trip is unknown
+        std::atomic_int slowCalls {0};
+        server->addMethod("slow", [&] () {
+            if (slowCalls++ == 0) {
+                std::this_thread::sleep_for(200ms); //the client resends meanwhile
+            }
+            return true;
+        });
+        server->addMethod("fast", [] () {
+            return true;
+        });
+        launchServerWithReadLoop();
+
+        std::atomic_int roundTrips {0};
+        client->setOnRoundTrip([&] (clock::duration) {
+            ++roundTrips;
+        });
+        client->setReadAsyncLoopEnabled(true);
+        launchClient([&] (CxnHandle cxn) {
+            client->callAsyncRetryNTimes(cxn, RB{}.id(0).method("slow").done(), 20, 50ms, [&, cxn] (CxnHandle, Message) {
+                EXPECT_EQ(roundTrips, 0);
+                client->callAsync(cxn, RB{}.id(1).method("fast").done(), [&] (CxnHandle, Message) {
+                    barrier.unblock();
+                });
+            });
+            client->readAsync(cxn);
+        });
+
+        ASSERT_NE(barrier.wait_for(2s), std::future_status::timeout);
+        EXPECT_GT(slowCalls, 1);
+        EXPECT_EQ(roundTrips, 1); //only the call that was sent once
+    }
+
 } // miner
 
 
@@ -0,0 +1,222 @@
+//
+//
+
+#include "JsonRpcFastParser.h"
+#include <cstring>
+#include <limits>
+
+namespace riner { namespace jrpc {
+
+    namespace {
+
+        /**
+         * recursive descent over the restricted grammar described in JsonRpcFastParser.h.
+         * every function returns false if it encounters anything it doesn't handle, so that the caller can fall back to the DOM parser
+         */
+        class Scanner {
+            const char *_p;
+            const char *const _end;
+
+        public:
+            Scanner(const std::string &str)
+            : _p(str.data()), _end(str.data() + str.size()) {
+            }
+
+            void skipWhitespace() {
+                while (_p != _end && (*_p == ' ' || *_p == '\t' || *_p == '\n' || *_p == '\r'))
+                    ++_p;
+            }
+
+            bool atEnd() const {
+                return _p == _end;
+            }
+
+            bool consume(char c) {
+                skipWhitespace();
+                if (_p != _end && *_p == c) {
+                    ++_p;
+                    return true;
+                }
+                return false;
+            }
+
+            bool peek(char c) {
+                skipWhitespace();
+                return _p != _end && *_p == c;
+            }
+
+            bool literal(const char *lit) {
+                size_t len = strlen(lit);
+                if (size_t(_end - _p) >= len && memcmp(_p, lit, len) == 0) {
+                    _p += len;
+                    return true;
+                }
+                return false;
+            }
+
+            //strings with escape sequences, control characters or non-ascii characters are left to the DOM parser
+            bool string(const char *&begin, size_t &size) {
+                if (!consume('"'))
+                    return false;
+                begin = _p;
+                for (; _p != _end; ++_p) {
+                    auto c = static_cast<unsigned char>(*_p);
+                    if (c == '"') {
+                        size = _p - begin;
+                        ++_p;
+                        return true;
+                    }
+                    if (c == '\\' || c < 0x20 || c >= 0x80)
+                        return false;
+                }
+                return false;
+            }
+
+            //only integers, nl::json::parse stores non-negative ones as number_unsigned which is replicated here
+            bool integer(nl::json &out) {
+                bool negative = _p != _end && *_p == '-';
+                if (negative)
+                    ++_p;
+
+                const char *digits = _p;
+                uint64_t value = 0;
+                for (; _p != _end && *_p >= '0' && *_p <= '9'; ++_p) {
+                    uint64_t digit = *_p - '0';
+                    if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10)
+                        return false;
+                    value = value * 10 + digit;
+                }
+
+                size_t numDigits = _p - digits;
+                if (numDigits == 0 || (numDigits > 1 && *digits == '0'))
+                    return false;
+                if (_p != _end && (*_p == '.' || *_p == 'e' || *_p == 'E'))
+                    return false; //floating point
+
+                if (negative) {
+                    if (value == 0 || value > uint64_t(std::numeric_limits<int64_t>::max()))
+                        return false;
+                    out = -int64_t(value);
+                }
+                else {
+                    out = value;
+                }
+                return true;
+            }
+
+            bool scalar(nl::json &out) {
+                skipWhitespace();
+                if (_p == _end)
+                    return false;
+
+                switch (*_p) {
+                    case '"': {
+                        const char *begin = nullptr;
+                        size_t size = 0;
+                        if (!string(begin, size))
+                            return false;
+                        out = std::string(begin, size);
+                        return true;
+                    }
+                    case 'n':
+                        out = nullptr;
+                        return literal("null");
+                    case 't':
+                        out = true;
+                        return literal("true");
+                    case 'f':
+                        out = false;
+                        return literal("false");
+                    default:
+                        return integer(out);
+                }
+            }
+
+            //a scalar or a flat array of scalars
+            bool value(nl::json &out) {
+                if (!consume('['))
+                    return scalar(out);
+
+                out = nl::json::array();
+                if (consume(']'))
+                    return true;
+
+                do {
+                    nl::json element;
+                    if (!scalar(element))
+                        return false;
+                    out.push_back(std::move(element));
+                } while (consume(','));
+
+                return consume(']');
+            }
+        };
+
+        enum Key {
+            key_id, key_jsonrpc, key_method, key_params, key_result, key_error, key_count
+        };
+
+        bool toKey(const char *begin, size_t size, Key &key) {
+            static const char *const names[key_count] = {"id", "jsonrpc", "method", "params", "result", "error"};
+            for (int i = 0; i < key_count; ++i) {
+                if (strlen(names[i]) == size && memcmp(names[i], begin, size) == 0) {
+                    key = static_cast<Key>(i);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    }
+
+    bool JsonRpcFastParser::tryParse(const std::string &line, Message &out) {
+        Scanner s{line};
+
+        if (!s.consume('{'))
+            return false;
+
+        nl::json values[key_count];
+        bool present[key_count] = {};
+
+        if (!s.peek('}')) {
+            do {
+                const char *keyBegin = nullptr;
+                size_t keySize = 0;
+                Key key;
+                if (!s.string(keyBegin, keySize) || !toKey(keyBegin, keySize, key) || present[key])
+                    return false; //unknown or duplicate key
+                if (!s.consume(':') || !s.value(values[key]))
+                    return false;
+                present[key] = true;
+            } while (s.consume(','));
+        }
+
+        if (!s.consume('}'))
+            return false;
+        s.skipWhitespace();
+        if (!s.atEnd())
+            return false;
+
+        if (present[key_error] && !values[key_error].is_null())
+            return false; //error objects are rare, leave them to Message(nl::json)
+
+        //same decisions as Message::Message(nl::json)
+        if (present[key_result]) {
+            out.var = Response{std::move(values[key_result])};
+        }
+        else {
+            if (!present[key_method] || !values[key_method].is_string())
+                return false; //let Message(nl::json) throw the appropriate error
+
+            Request req;
+            req.method = std::move(values[key_method].get_ref<std::string &>());
+            if (present[key_params])
+                req.params = std::move(values[key_params]);
+            out.var = std::move(req);
+        }
+
+        out.id = present[key_id] ? std::move(values[key_id]) : nl::json{};
+        return true;
+    }
+
+}}
@@ -0,0 +1,33 @@
+//
+//
+
+#pragma once
+
+#include <string>
+#include "JsonRpcMessage.h"
+
+namespace riner { namespace jrpc {
+
+    /**
+     * Parses the json-rpc message shapes that make up most of the stratum traffic (e.g. `mining.notify` with a flat
+     * params array, or `{"id":N,"result":true,"error":null}` share responses) directly into a `jrpc::Message`, without
+     * building an intermediate `nl::json` object for the whole line.
+     *
+     * Only flat messages are recognized: a single json object whose members are `id`, `jsonrpc`, `method`, `params`,
+     * `result` or `error`, where every value is `null`, a bool, an integer, a string without escape sequences, or an
+     * array of those (`error` must be `null`). For everything else `tryParse` returns `false` and the line is expected
+     * to go through the regular `nl::json::parse` path. If `tryParse` returns `true` the resulting `Message` is equal to
+     * the one that `Message{nl::json::parse(line)}` would produce.
+     */
+    class JsonRpcFastParser {
+    public:
+
+        /**
+         * @param line a single line containing one json-rpc message
+         * @param out is assigned the parsed message if `true` is returned, it may be left in a modified state otherwise
+         * @return whether the line was recognized and parsed
+         */
+        static bool tryParse(const std::string &line, Message &out);
+    };
+
+}}
@@ -0,0 +1,93 @@
+
+#include <src/network/JsonRpcFastParser.h>
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+
+namespace riner {
+namespace jrpc {
+namespace {
+
+//messages as they were received from ethash and grin stratum pools
+const std::vector<std::string> recordedFlatMessages = {
+    R"({"id":null,"method":"mining.notify","params":["0x1b4e2cd81bbd8b3a08e3d5b1a7b1c5da4e7c2d1b0a3f6e9d8c7b6a5f4e3d2c1b","0xd1b0a3f6e9d8c7b6a5f4e3d2c1b1b4e2cd81bbd8b3a08e3d5b1a7b1c5da4e7c2","0x00000000ffff0000000000000000000000000000000000000000000000000000",true]})",
+    R"({"id":0,"jsonrpc":"2.0","result":["0x1b4e2cd81bbd8b3a08e3d5b1a7b1c5da4e7c2d1b0a3f6e9d8c7b6a5f4e3d2c1b","0xd1b0a3f6e9d8c7b6a5f4e3d2c1b1b4e2cd81bbd8b3a08e3d5b1a7b1c5da4e7c2","0x00000000ffff0000000000000000000000000000000000000000000000000000"]})",
+    R"({"id":42,"result":true,"error":null})",
+    R"({"id":43,"jsonrpc":"2.0","result":false})",
+    R"( { "id" : -7 , "result" : true } )" "\r\n",
+    R"({"id":"submit","method":"mining.submit","params":["worker.1","6f2a","0x0123456789abcdef"]})",
+    R"({"jsonrpc":"2.0","method":"ping"})",
+    R"({"id":1,"method":"eth_getWork","params":[]})",
+};
+
+//messages that need the DOM parser
+const std::vector<std::string> recordedNestedMessages = {
+    R"({"id":1,"result":[["mining.notify","ae6812eb4cd7735a302a8a9dd95cf71f"],"08000002",4],"error":null})",
+    R"({"id":null,"method":"mining.set_difficulty","params":[0.5]})",
+    R"({"id":3,"result":null,"error":[21,"Job not found",null]})",
+    R"({"id":"4","jsonrpc":"2.0","method":"job","params":{"difficulty":1,"height":16375,"job_id":4,"pre_pow":"0001000000000000"}})",
+    R"({"id":5,"result":"escaped \"string\""})",
+};
+
+TEST(JsonRpcFastParser, MatchesDomParser) {
+    for (auto &line : recordedFlatMessages) {
+        Message fast;
+        ASSERT_TRUE(JsonRpcFastParser::tryParse(line, fast)) << line;
+
+        Message dom{nl::json::parse(line)};
+        EXPECT_EQ(fast.toJson().dump(), dom.toJson().dump()) << line;
+        EXPECT_EQ(fast.id.type(), dom.id.type()) << line;
+        EXPECT_EQ(fast.isRequest(), dom.isRequest()) << line;
+        EXPECT_EQ(fast.isNotification(), dom.isNotification()) << line;
+    }
+}
+
+TEST(JsonRpcFastParser, LeavesOtherMessagesToDomParser) {
+    for (auto &line : recordedNestedMessages) {
+        Message msg;
+        EXPECT_FALSE(JsonRpcFastParser::tryParse(line, msg)) << line;
+    }
+
+    for (std::string line : {"", "{", "[1,2]", R"({"id":1,"result":true} x)", R"({"id":1,"id":2,"result":true})",
+                             R"({"id":01,"result":true})", R"({"id":18446744073709551616,"result":true})", R"({"id":1})"}) {
+        Message msg;
+        EXPECT_FALSE(JsonRpcFastParser::tryParse(line, msg)) << line;
+    }
+}
+
+//microbenchmark, run with --gtest_also_run_disabled_tests
+TEST(JsonRpcFastParser, DISABLED_BenchmarkAgainstDomParser) {
+    using namespace std::chrono;
+    const size_t iterations = 100000;
+    const auto &lines = recordedFlatMessages;
+
+    auto start = steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        Message msg{nl::json::parse(lines[i % lines.size()])};
+    }
+    auto domTime = steady_clock::now() - start;
+
+    start = steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        Message msg;
+        JsonRpcFastParser::tryParse(lines[i % lines.size()], msg);
+    }
+    auto fastTime = steady_clock::now() - start;
+
+    size_t bytes = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+        bytes += lines[i % lines.size()].size();
+    }
+
+    auto rate = [&] (steady_clock::duration d) {
+        return double(bytes) / duration<double>(d).count() / 1e6;
+    };
+    std::cout << iterations << " recorded messages:" << std::endl
+              << "    Message{nl::json::parse(line)}: " << duration<double, std::nano>(domTime).count() / iterations << " ns/msg, " << rate(domTime) << " MB/s" << std::endl
+              << "    JsonRpcFastParser::tryParse:    " << duration<double, std::nano>(fastTime).count() / iterations << " ns/msg, " << rate(fastTime) << " MB/s" << std::endl;
+}
+
+} // namespace
+} // jrpc
+} // riner
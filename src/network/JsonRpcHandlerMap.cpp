@@ -2,31 +2,143 @@
 //
 
 #include "JsonRpcHandlerMap.h"
+#include <limits>
 
 namespace riner { namespace jrpc {
 
+    constexpr size_t HandlerMap::wheelSlots;
+    constexpr clock::duration HandlerMap::tickDuration;
+
     void responseHandlerNoop(CxnHandle, const Message &) {}
 
+    namespace {
+
+        //integers that fit into int64_t (signed or unsigned, like nl::json's operator== treats them)
+        bool isNumberId(const nl::json &id) {
+            if (id.is_number_unsigned())
+                return id.get<uint64_t>() <= uint64_t(std::numeric_limits<int64_t>::max());
+            return id.is_number_integer();
+        }
+
+        template<class Map, class Key>
+        optional<ResponseHandler> popAny(Map &map, const Key &key) {
+            auto it = map.find(key); //find first
+            if (it == map.end())
+                return nullopt;
+
+            ResponseHandler handler = std::move(it->second.handler);
+            map.erase(it); //erase one of the entries with this id
+            return std::move(handler);
+        }
+
+        template<class Map, class Key>
+        bool eraseSerial(Map &map, const Key &key, uint64_t serial) {
+            auto range = map.equal_range(key);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second.serial == serial) {
+                    map.erase(it);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    }
+
+    HandlerMap::HandlerMap(clock::duration timeout) {
+        _state.lock()->timeout = timeout;
+    }
+
+    void HandlerMap::setTimeout(clock::duration timeout) {
+        _state.lock()->timeout = timeout;
+    }
+
     void HandlerMap::addForId(nl::json id, ResponseHandler &&handler) {
-        _mmap.lock()->insert({std::move(id), make_unique<ResponseHandler>(std::move(handler))});
+        auto now = clock::now();
+        auto state = _state.lock();
+        state->expire(now);
+
+        uint64_t serial = state->nextSerial++;
+
+        //ticks until the timer fires, rounded up and +1 since the current tick has already begun
+        auto ticks = uint64_t((state->timeout + tickDuration - clock::duration(1)) / tickDuration) + 1;
+        state->wheel[(state->tick + ticks) % wheelSlots].push_back(Timer{id, serial, (ticks - 1) / wheelSlots});
+
+        if (isNumberId(id)) {
+            state->byNumber.emplace(id.get<int64_t>(), Entry{serial, std::move(handler)});
+        }
+        else if (id.is_string()) {
+            state->byString.emplace(id.get<std::string>(), Entry{serial, std::move(handler)});
+        }
+        else {
+            state->byOther.emplace(std::move(id), Entry{serial, std::move(handler)});
+        }
     }
 
     optional<ResponseHandler> HandlerMap::tryPopForId(const nl::json &id) {
-        unique_ptr<ResponseHandler> handler;
+        auto now = clock::now();
+        auto state = _state.lock();
+        state->expire(now);
 
-        { auto mmap = _mmap.lock();
+        if (isNumberId(id))
+            return popAny(state->byNumber, id.get<int64_t>());
+        if (id.is_string())
+            return popAny(state->byString, id.get_ref<const std::string &>());
+        return popAny(state->byOther, id);
+    }
 
-            auto it = mmap->find(id); //find first
-            if (it != mmap->end()) {
-                handler = std::move(it->second);
-                mmap->erase(it); //erase one of the entries with this id
+    size_t HandlerMap::expire(clock::time_point now) {
+        return _state.lock()->expire(now);
+    }
+
+    size_t HandlerMap::size() const {
+        return _state.lock()->size();
+    }
+
+    size_t HandlerMap::State::size() const {
+        return byNumber.size() + byString.size() + byOther.size();
+    }
+
+    size_t HandlerMap::State::expire(clock::time_point now) {
+        if (size() == 0) {
+            //nothing can expire, skip the idle ticks (timers of popped handlers are irrelevant)
+            for (auto &slot : wheel)
+                slot.clear();
+            tickTime = std::max(tickTime, now);
+            return 0;
+        }
+
+        size_t expired = 0;
+        while (tickTime + tickDuration <= now) {
+            tickTime += tickDuration;
+            ++tick;
+
+            auto &slot = wheel[tick % wheelSlots];
+            size_t kept = 0;
+            for (size_t i = 0; i < slot.size(); ++i) {
+                auto &timer = slot[i];
+                if (timer.rounds > 0) {
+                    --timer.rounds;
+                    if (kept != i)
+                        slot[kept] = std::move(timer);
+                    ++kept;
+                }
+                else if (erase(timer.id, timer.serial)) { //no-op if a response arrived in the meantime
+                    VLOG(3) << "dropping jrpc response handler for id '" << timer.id << "' since no response arrived in time";
+                    ++expired;
+                }
             }
-        } //unlock
+            slot.resize(kept);
+        }
+        return expired;
+    }
 
-        if (handler)
-            return std::move(*handler); //move handler out of unique_ptr
-        else
-            return nullopt;
+    bool HandlerMap::State::erase(const nl::json &id, uint64_t serial) {
+        if (isNumberId(id))
+            return eraseSerial(byNumber, id.get<int64_t>(), serial);
+        if (id.is_string())
+            return eraseSerial(byString, id.get_ref<const std::string &>(), serial);
+        return eraseSerial(byOther, id, serial);
     }
 
-}}
\ No newline at end of file
+}}
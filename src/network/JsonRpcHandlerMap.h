@@ -4,8 +4,11 @@
 #pragma once
 
 #include <map>
+#include <unordered_map>
+#include <vector>
 #include <functional>
 #include <src/util/LockUtils.h>
+#include <src/common/Chrono.h>
 #include <src/common/JsonForward.h>
 #include <src/network/BaseIO.h>
 #include <src/network/JsonRpcMessage.h>
@@ -21,9 +24,14 @@ namespace riner { namespace jrpc {
     //is incoming.
     //multiple jrpcs with the same id can be submitted, however the handlers of
     //those ids are then most likely not going to be called in the assumed order
+    //
+    //integer and string ids (which is what every caller uses) are kept in hash maps, any other id in a std::multimap.
+    //handlers that didn't get a response within the timeout are dropped via a timer wheel, so that the map stays
+    //bounded if a peer never responds to some requests. the wheel advances lazily on every addForId/tryPopForId call
     class HandlerMap {
-        LockGuarded<std::multimap<nl::json, unique_ptr<ResponseHandler>>> _mmap;
     public:
+        explicit HandlerMap(clock::duration timeout = std::chrono::minutes(5));
+
         //pushes a handler for the given id onto the map
         //supports pushing the same id multiple times
         void addForId(nl::json requestId, ResponseHandler &&);
@@ -31,6 +39,48 @@ namespace riner { namespace jrpc {
         //returns nullopt if no handler with given id is inside the map
         //otherwise returns one of the handlers of that id and removes it from the map
         optional<ResponseHandler> tryPopForId(const nl::json &responseId);
+
+        //sets the time after which handlers that were added from now on are dropped if no response arrived
+        void setTimeout(clock::duration timeout);
+
+        //drops all handlers whose timeout has passed at time 'now', returns how many were dropped
+        size_t expire(clock::time_point now);
+
+        //number of handlers currently waiting for a response
+        size_t size() const;
+
+    private:
+        struct Entry {
+            uint64_t serial; //identifies the entry for its timer
+            ResponseHandler handler;
+        };
+
+        struct Timer {
+            nl::json id;
+            uint64_t serial;
+            uint64_t rounds; //full turns of the wheel that are left before the timer fires
+        };
+
+        static constexpr size_t wheelSlots = 64;
+        static constexpr clock::duration tickDuration = std::chrono::seconds(1);
+
+        struct State {
+            std::unordered_multimap<int64_t, Entry> byNumber;
+            std::unordered_multimap<std::string, Entry> byString;
+            std::multimap<nl::json, Entry> byOther;
+
+            std::vector<std::vector<Timer>> wheel = std::vector<std::vector<Timer>>(wheelSlots);
+            uint64_t tick = 0; //index of the current tick (modulo wheelSlots is the current slot)
+            clock::time_point tickTime = clock::now(); //start of the current tick
+            clock::duration timeout;
+            uint64_t nextSerial = 0;
+
+            size_t size() const;
+            size_t expire(clock::time_point now);
+            bool erase(const nl::json &id, uint64_t serial);
+        };
+
+        LockGuarded<State> _state;
     };
 
 }}
@@ -0,0 +1,77 @@
+
+#include <src/network/JsonRpcHandlerMap.h>
+
+#include <gtest/gtest.h>
+
+namespace riner {
+namespace jrpc {
+namespace {
+
+ResponseHandler makeHandler(int &calls) {
+    return [&calls] (CxnHandle, const Message &) {
+        ++calls;
+    };
+}
+
+TEST(HandlerMap, PopsByIdOfAnyType) {
+    HandlerMap map;
+    int numberCalls = 0, stringCalls = 0, otherCalls = 0;
+
+    map.addForId(int64_t(5), makeHandler(numberCalls));
+    map.addForId("5", makeHandler(stringCalls));
+    map.addForId(nullptr, makeHandler(otherCalls));
+    EXPECT_EQ(map.size(), 3);
+
+    //signed and unsigned json integers are the same id
+    auto handler = map.tryPopForId(uint64_t(5));
+    ASSERT_TRUE(handler.has_value());
+    (*handler)(CxnHandle{}, Message{});
+    EXPECT_EQ(numberCalls, 1);
+    EXPECT_FALSE(map.tryPopForId(int64_t(5)).has_value());
+
+    EXPECT_TRUE(map.tryPopForId("5").has_value());
+    EXPECT_TRUE(map.tryPopForId(nullptr).has_value());
+    EXPECT_FALSE(map.tryPopForId(~uint64_t(0)).has_value());
+    EXPECT_EQ(map.size(), 0);
+}
+
+TEST(HandlerMap, SameIdCanBeAddedMultipleTimes) {
+    HandlerMap map;
+    int calls = 0;
+
+    map.addForId(1, makeHandler(calls));
+    map.addForId(1, makeHandler(calls));
+
+    EXPECT_TRUE(map.tryPopForId(1).has_value());
+    EXPECT_TRUE(map.tryPopForId(1).has_value());
+    EXPECT_FALSE(map.tryPopForId(1).has_value());
+}
+
+TEST(HandlerMap, ExpiresHandlersWithoutResponse) {
+    HandlerMap map {std::chrono::seconds(100)}; //longer than one turn of the timer wheel
+    int calls = 0;
+    auto start = clock::now();
+
+    map.addForId(1, makeHandler(calls));
+    map.addForId("2", makeHandler(calls));
+    map.addForId(3, makeHandler(calls));
+    EXPECT_TRUE(map.tryPopForId(3).has_value()); //responded in time
+
+    map.setTimeout(std::chrono::seconds(300));
+    map.addForId(4, makeHandler(calls));
+
+    EXPECT_EQ(map.expire(start + std::chrono::seconds(99)), 0);
+    EXPECT_EQ(map.size(), 3);
+
+    EXPECT_EQ(map.expire(start + std::chrono::seconds(102)), 2);
+    EXPECT_EQ(map.size(), 1);
+    EXPECT_FALSE(map.tryPopForId(1).has_value());
+
+    EXPECT_EQ(map.expire(start + std::chrono::seconds(302)), 1);
+    EXPECT_EQ(map.size(), 0);
+    EXPECT_EQ(calls, 0);
+}
+
+} // namespace
+} // jrpc
+} // riner
@@ -17,4 +17,15 @@ namespace riner { namespace jrpc {
             return msg.toJson();
         }
 
+        void JsonRpcIO::setOnReceive(OnReceiveValueFunc &&onRecv) {
+            setOnReceiveWithShortcut(std::move(onRecv), [this] (const std::string &line, Message &msg) {
+                return _fastParserEnabled && JsonRpcFastParser::tryParse(line, msg);
+            });
+        }
+
+        void JsonRpcIO::setFastParserEnabled(bool enabled) {
+            checkNotLaunchedOrOnIOThread();
+            _fastParserEnabled = enabled;
+        }
+
     }}
\ No newline at end of file
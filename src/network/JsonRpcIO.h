@@ -4,6 +4,7 @@
 #pragma once
 #include "JsonIO.h"
 #include "JsonRpcMessage.h"
+#include "JsonRpcFastParser.h"
 
 namespace riner { namespace jrpc {
 
@@ -14,9 +15,24 @@ namespace riner { namespace jrpc {
 
         Message convertIncoming(nl::json) override;
         nl::json convertOutgoing(Message) override;
+
+        bool _fastParserEnabled = true;
     public:
         using IOTypeLayer::IOTypeLayer; //expose base ctors
 
+        /**
+         * same as `IOTypeLayer::setOnReceive()`, but incoming lines are first offered to `JsonRpcFastParser`, which
+         * converts the common flat messages without building an `nl::json` for the whole line. Other lines
+         * are parsed by the `JsonIO` layer as usual
+         */
+        void setOnReceive(OnReceiveValueFunc &&);
+
+        /**
+         * enable or disable the fast path of `setOnReceive()` (enabled by default). Results are identical either way,
+         * so this is mostly useful for comparisons. May only be called before launching or from the io thread
+         */
+        void setFastParserEnabled(bool enabled);
+
         ~JsonRpcIO() override {stopIOThread();}
     };
 
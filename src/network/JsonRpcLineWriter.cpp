@@ -0,0 +1,178 @@
+//
+//
+
+#include <src/common/Assert.h>
+#include "JsonRpcLineWriter.h"
+#include <cstring>
+
+namespace riner { namespace jrpc {
+
+        RequestLineWriter &RequestLineWriter::id(Number id) {
+            _buf.clear();
+            _params = Params::none;
+            _lastKey = nullptr;
+
+            _buf += "{\"id\":";
+            appendNumber(int64_t(id));
+            return *this;
+        }
+
+        RequestLineWriter &RequestLineWriter::idAsString(Number id) {
+            _buf.clear();
+            _params = Params::none;
+            _lastKey = nullptr;
+
+            _buf += "{\"id\":\"";
+            appendNumber(int64_t(id));
+            _buf += '"';
+            return *this;
+        }
+
+        RequestLineWriter &RequestLineWriter::method(const std::string &name) {
+            RNR_EXPECTS(!_buf.empty()); //id() must be called first
+            _buf += ",\"jsonrpc\":\"2.0\",\"method\":";
+            appendString(name.data(), name.size());
+            _buf += ",\"params\":";
+            return *this;
+        }
+
+        void RequestLineWriter::beginParam() {
+            RNR_EXPECTS(_params != Params::named);
+            _buf += _params == Params::none ? '[' : ',';
+            _params = Params::unnamed;
+        }
+
+        void RequestLineWriter::beginParam(const char *key) {
+            RNR_EXPECTS(_params != Params::unnamed);
+            RNR_EXPECTS(!_lastKey || strcmp(_lastKey, key) < 0); //nl::json objects are sorted by key
+            _buf += _params == Params::none ? '{' : ',';
+            _params = Params::named;
+            _lastKey = key;
+
+            appendString(key, strlen(key));
+            _buf += ':';
+        }
+
+        RequestLineWriter &RequestLineWriter::param(const std::string &str) {
+            beginParam();
+            appendString(str.data(), str.size());
+            return *this;
+        }
+
+        RequestLineWriter &RequestLineWriter::param(int64_t n) {
+            beginParam();
+            appendNumber(n);
+            return *this;
+        }
+
+        RequestLineWriter &RequestLineWriter::paramHex(cByteSpan<> bytes) {
+            beginParam();
+            appendHex(bytes);
+            return *this;
+        }
+
+        RequestLineWriter &RequestLineWriter::param(const char *key, const std::string &str) {
+            beginParam(key);
+            appendString(str.data(), str.size());
+            return *this;
+        }
+
+        RequestLineWriter &RequestLineWriter::param(const char *key, int64_t n) {
+            beginParam(key);
+            appendNumber(n);
+            return *this;
+        }
+
+        RequestLineWriter &RequestLineWriter::param(const char *key, uint64_t n) {
+            beginParam(key);
+            appendNumber(n);
+            return *this;
+        }
+
+        RequestLineWriter &RequestLineWriter::param(const char *key, const std::vector<uint32_t> &array) {
+            beginParam(key);
+            _buf += '[';
+            for (size_t i = 0; i < array.size(); ++i) {
+                if (i > 0)
+                    _buf += ',';
+                appendNumber(uint64_t(array[i]));
+            }
+            _buf += ']';
+            return *this;
+        }
+
+        std::string RequestLineWriter::done() {
+            switch (_params) {
+                case Params::none:    _buf += "null"; break;
+                case Params::unnamed: _buf += ']'; break;
+                case Params::named:   _buf += '}'; break;
+            }
+            _buf += "}\n";
+            return _buf; //copy, so that _buf keeps its capacity
+        }
+
+        void RequestLineWriter::appendString(const char *str, size_t size) {
+            static const char digits[] = "0123456789abcdef";
+            _buf += '"';
+            for (size_t i = 0; i < size; ++i) {
+                auto c = static_cast<unsigned char>(str[i]);
+                switch (c) {
+                    case '"':  _buf += "\\\""; break;
+                    case '\\': _buf += "\\\\"; break;
+                    case '\b': _buf += "\\b"; break;
+                    case '\f': _buf += "\\f"; break;
+                    case '\n': _buf += "\\n"; break;
+                    case '\r': _buf += "\\r"; break;
+                    case '\t': _buf += "\\t"; break;
+                    default:
+                        if (c < 0x20) {
+                            _buf += "\\u00";
+                            _buf += digits[c >> 4];
+                            _buf += digits[c & 0xf];
+                        }
+                        else {
+                            _buf += char(c);
+                        }
+                }
+            }
+            _buf += '"';
+        }
+
+        void RequestLineWriter::appendHex(cByteSpan<> bytes) {
+            static const char digits[] = "0123456789abcdef";
+            size_t pos = _buf.size();
+            _buf.resize(pos + 4 + 2 * bytes.size()); //quotes, "0x" and two digits per byte
+
+            char *out = &_buf[pos];
+            *out++ = '"';
+            *out++ = '0';
+            *out++ = 'x';
+            for (uint8_t byte : bytes) {
+                *out++ = digits[byte >> 4];
+                *out++ = digits[byte & 0xf];
+            }
+            *out = '"';
+        }
+
+        void RequestLineWriter::appendNumber(uint64_t n) {
+            char tmp[20];
+            char *end = tmp + sizeof(tmp);
+            char *begin = end;
+            do {
+                *--begin = char('0' + n % 10);
+                n /= 10;
+            } while (n != 0);
+            _buf.append(begin, end);
+        }
+
+        void RequestLineWriter::appendNumber(int64_t n) {
+            if (n < 0) {
+                _buf += '-';
+                appendNumber(uint64_t(0) - uint64_t(n));
+            }
+            else {
+                appendNumber(uint64_t(n));
+            }
+        }
+
+    }}
@@ -0,0 +1,69 @@
+//
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <src/common/Span.h>
+#include "JsonRpcMessage.h"
+
+namespace riner { namespace jrpc {
+
+    /**
+     * Renders a json-rpc request directly into a reusable buffer, as an alternative to `RequestBuilder` for hot
+     * messages of a known shape (e.g. share submissions). The produced line is byte-for-byte identical to what
+     * `RequestBuilder` + `Message::str()` would send (keys in `nl::json`'s sorted order, same escaping), including the
+     * trailing `'\n'`, so it can be passed directly to the line layer (see `JsonRpcUtil::RetriedCall::line`).
+     *
+     * usage: `writer.id(5).method("mining.submit").param(user).paramHex(nonceBytes).done()`
+     *
+     * Params must be either all unnamed or all named. Named params must be added in ascending key order, since `nl::json`
+     * objects are sorted. The buffer's capacity is kept between messages, so an instance should be reused (not thread safe).
+     */
+    class RequestLineWriter {
+        std::string _buf;
+
+        enum class Params {none, unnamed, named};
+        Params _params = Params::none;
+        const char *_lastKey = nullptr;
+
+        void beginParam();
+        void beginParam(const char *key);
+        void appendString(const char *str, size_t size); //quoted and escaped like nl::json::dump
+        void appendHex(cByteSpan<> bytes); //quoted, with "0x" prefix, lowercase and two digits per byte
+        void appendNumber(uint64_t);
+        void appendNumber(int64_t);
+
+    public:
+        /**
+         * starts a new request with a `Number` id, discarding whatever was written before
+         */
+        RequestLineWriter &id(Number id);
+
+        /**
+         * starts a new request with the decimal representation of `id` as a `String` id (e.g. for grin stratum)
+         */
+        RequestLineWriter &idAsString(Number id);
+
+        RequestLineWriter &method(const std::string &name);
+
+        //unnamed params
+        RequestLineWriter &param(const std::string &str);
+        RequestLineWriter &param(int64_t);
+        RequestLineWriter &paramHex(cByteSpan<> bytes);
+
+        //named params, must be added in ascending key order
+        RequestLineWriter &param(const char *key, const std::string &str);
+        RequestLineWriter &param(const char *key, int64_t);
+        RequestLineWriter &param(const char *key, uint64_t);
+        RequestLineWriter &param(const char *key, const std::vector<uint32_t> &array);
+
+        /**
+         * finishes the request
+         * @return the request as a line ending with `'\n'`. the internal buffer keeps its capacity for the next request
+         */
+        std::string done();
+    };
+
+}}
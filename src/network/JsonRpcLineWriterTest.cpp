@@ -0,0 +1,95 @@
+
+#include <src/network/JsonRpcLineWriter.h>
+#include <src/network/JsonRpcBuilder.h>
+#include <src/util/HexString.h>
+#include <src/util/Bytes.h>
+
+#include <gtest/gtest.h>
+
+namespace riner {
+namespace jrpc {
+namespace {
+
+Bytes<32> makeBytes(uint8_t first) {
+    Bytes<32> bytes;
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = uint8_t(first + 7 * i);
+    }
+    return bytes;
+}
+
+TEST(RequestLineWriter, EthashSubmitMatchesJsonPath) {
+    RequestLineWriter writer;
+
+    for (std::string username : {"0x5a0b54d5dc17e0aadc383d2db43b0a0d3e029c4c.rig1", "user \"with\" \\ quotes\tand\x01 control"}) {
+        for (uint64_t nonce : {uint64_t(0), uint64_t(0x00ff00ff12345678), ~uint64_t(0)}) {
+            auto header = makeBytes(uint8_t(nonce));
+            auto mixHash = makeBytes(0xf0);
+            int64_t id = int64_t(nonce % 1000);
+
+            std::string expected = RequestBuilder{}
+                    .id(id)
+                    .method("mining.submit")
+                    .param(username)
+                    .param("0x12ab")
+                    .param("0x" + HexString(toBytesWithBigEndian(nonce)).str())
+                    .param("0x" + HexString(header).str())
+                    .param("0x" + HexString(mixHash).str())
+                    .done().str() + '\n';
+
+            std::string line = writer.id(id)
+                    .method("mining.submit")
+                    .param(username)
+                    .param("0x12ab")
+                    .paramHex(toBytesWithBigEndian(nonce))
+                    .paramHex(header)
+                    .paramHex(mixHash)
+                    .done();
+
+            EXPECT_EQ(line, expected);
+        }
+    }
+}
+
+TEST(RequestLineWriter, GrinSubmitMatchesJsonPath) {
+    RequestLineWriter writer;
+    std::vector<uint32_t> pow;
+    for (uint32_t i = 0; i < 42; ++i) {
+        pow.push_back(i * 49999991u);
+    }
+
+    for (int64_t id : {0, 17, 123456789}) {
+        nl::json powJson = pow;
+        auto j = RequestBuilder{}
+                .id(id)
+                .method("submit")
+                .param("edge_bits", 31)
+                .param("height", int64_t(-id)) //negative numbers are not realistic here, but must match anyway
+                .param("job_id", int64_t(4))
+                .param("nonce", uint64_t(uint64_t(id) * 0x9e3779b97f4a7c15ull))
+                .param("pow", powJson)
+                .done().toJson();
+        j["id"] = std::to_string(id); //what PoolGrin's outgoing modifier does
+        std::string expected = j.dump() + '\n';
+
+        std::string line = writer.idAsString(id)
+                .method("submit")
+                .param("edge_bits", int64_t(31))
+                .param("height", int64_t(-id))
+                .param("job_id", int64_t(4))
+                .param("nonce", uint64_t(uint64_t(id) * 0x9e3779b97f4a7c15ull))
+                .param("pow", pow)
+                .done();
+
+        EXPECT_EQ(line, expected);
+    }
+}
+
+TEST(RequestLineWriter, NoParams) {
+    RequestLineWriter writer;
+    EXPECT_EQ(writer.id(-3).method("ping").done(), RequestBuilder{}.id(-3).method("ping").done().str() + '\n');
+}
+
+} // namespace
+} // jrpc
+} // riner
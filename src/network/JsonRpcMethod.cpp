@@ -2,3 +2,17 @@
 //
 
 #include "JsonRpcMethod.h"
+
+namespace riner { namespace jrpc {
+
+    Message invokeMatchingMethod(const MethodTable &methods, const Message &request) {
+        RNR_EXPECTS(request.isRequest());
+
+        auto it = methods.find(var::get<Request>(request.var).method);
+        if (it == methods.end()) {
+            return Message{Response{Error{jrpc::method_not_found}}, request.id};
+        }
+        return it->second.invoke(request);
+    }
+
+}}
@@ -5,6 +5,7 @@
 
 #include <string>
 #include <functional>
+#include <unordered_map>
 #include <src/common/Assert.h>
 #include <src/util/TemplateUtils.h>
 #include "JsonRpcMessage.h"
@@ -57,4 +58,10 @@ namespace riner { namespace jrpc {
         return response;
     }
 
+    using MethodTable = std::unordered_map<std::string, Method>; //method name -> Method
+
+    //looks up the method with the request's name in a MethodTable (constant time instead of iterating)
+    //if theres no match, returns response message with Error jrpc::method_not_found
+    Message invokeMatchingMethod(const MethodTable &methods, const Message &request);
+
 }}
@@ -53,16 +53,29 @@ namespace riner { namespace jrpc {
 
         void JsonRpcUtil::callAsync(CxnHandle cxn, Message request, ResponseHandler &&handler) {
             RNR_EXPECTS(request.isRequest());
-            _pending.addForId(request.id, std::move(handler));
+            trackResponse(request, std::move(handler));
             writeAsync(cxn, std::move(request)); //send rpc call
         }
 
-        bool JsonRpcUtil::hasMethod(const char *name) const {
-            for (auto &method : _methods) {
-                if (method.name() == name)
-                    return true;
+        void JsonRpcUtil::trackResponse(const Message &request, ResponseHandler &&handler, std::shared_ptr<const bool> resent) {
+            if (_onRoundTrip) {
+                ResponseHandler timedHandler = [this, sentTime = clock::now(), resent = std::move(resent), handler = std::move(handler)] (CxnHandle cxn, const Message &response) {
+                    if (!resent || !*resent) {
+                        _onRoundTrip(clock::now() - sentTime);
+                    }
+                    handler(cxn, response);
+                };
+                handler = std::move(timedHandler);
             }
-            return false;
+            _pending.addForId(request.id, std::move(handler));
+        }
+
+        bool JsonRpcUtil::hasMethod(const char *name) const {
+            return _methods.count(name) != 0;
+        }
+
+        void JsonRpcUtil::setResponseTimeout(clock::duration timeout) {
+            _pending.setTimeout(timeout);
         }
 
         void JsonRpcUtil::setReadAsyncLoopEnabled(bool val) {
@@ -70,41 +83,111 @@ namespace riner { namespace jrpc {
             _readAsyncLoopEnabled = val;
         }
 
+        void JsonRpcUtil::setOnRoundTrip(std::function<void(clock::duration)> onRoundTrip) {
+            RNR_EXPECTS(isIoThread() || !hasLaunched());
+            _onRoundTrip = std::move(onRoundTrip);
+        }
+
         void JsonRpcUtil::callAsyncRetryNTimes(CxnHandle cxn, Message request, uint32_t maxTries, milliseconds freq, ResponseHandler &&handler,
-                                               std::function<void()> neverRespondedHandler) {
+                                               std::function<void()> neverRespondedHandler, std::function<void()> timeoutHandler) {
 
             auto stillPending = std::make_shared<bool>(true);
-            uint32_t tries = 0;
+            auto resent = std::make_shared<bool>(false);
+            bool firstTrySent = false;
+            retryUntilResponded(std::move(cxn), std::move(request), "", std::move(stillPending), std::move(resent), firstTrySent, maxTries, freq,
+                    std::move(handler), std::move(neverRespondedHandler), std::move(timeoutHandler));
+        }
+
+        void JsonRpcUtil::callAsyncRetryNTimes(CxnHandle cxn, std::vector<RetriedCall> calls, uint32_t maxTries, milliseconds freq) {
+            RNR_EXPECTS(isIoThread());
+
+            std::vector<std::string> firstTries; //one line per call, in the order of calls
+
+            for (auto &call : calls) {
+                RNR_EXPECTS(call.request.isRequest());
+                auto stillPending = std::make_shared<bool>(true);
+                auto resent = std::make_shared<bool>(false);
+
+                trackResponse(call.request, [handler = std::move(call.handler), stillPending] (CxnHandle cxn, auto response) {
+                    *stillPending = false;
+                    handler(cxn, std::move(response));
+                }, resent);
+                if (call.line.empty()) {
+                    try {
+                        firstTries.push_back(processOutgoingTwoLayersDown(call.request));
+                    }
+                    catch(const IOConversionError &e) {
+                        LOG(WARNING) << "IOTypeLayer conversion failed on asyncWrite: " << e.what();
+                    }
+                }
+                else {
+                    firstTries.push_back(call.line);
+                }
+
+                bool firstTrySent = true;
+                retryUntilResponded(cxn, std::move(call.request), std::move(call.line), std::move(stillPending), std::move(resent), firstTrySent, maxTries, freq,
+                        responseHandlerNoop, std::move(call.neverRespondedHandler), std::move(call.timeoutHandler));
+            }
+
+            if (!firstTries.empty()) {
+                layerBelow().layerBelow().writeAsync(cxn, std::move(firstTries)); //LineIO, a single socket write
+            }
+        }
+
+        void JsonRpcUtil::writeRequest(CxnHandle cxn, const Message &request, const std::string &line) {
+            if (line.empty()) {
+                writeAsync(cxn, request);
+            }
+            else {
+                layerBelow().layerBelow().writeAsync(cxn, line); //LineIO
+            }
+        }
+
+        void JsonRpcUtil::retryUntilResponded(CxnHandle cxn, Message request, std::string line, std::shared_ptr<bool> stillPending,
+                                              std::shared_ptr<bool> resent, bool firstTrySent,
+                                              uint32_t maxTries, milliseconds freq, ResponseHandler &&handler,
+                                              std::function<void()> neverRespondedHandler, std::function<void()> timeoutHandler) {
+
+            uint32_t tries = firstTrySent ? 1 : 0;
+            bool skipNextCall = firstTrySent; //retryAsyncEvery calls the predicate right away, not after the first interval
 
             //this function keeps retrying until the provided lambda returns true
             retryAsyncEvery(freq, [this, cxn = std::move(cxn), //move all the args into the lambda
-                                   stillPending, tries, maxTries,
-                                   neverRespondedHandler,
-                                   request = std::move(request),
+                                   stillPending, resent, tries, maxTries, skipNextCall,
+                                   neverRespondedHandler, timeoutHandler,
+                                   request = std::move(request), line = std::move(line),
                                    handler = std::move(handler)] () mutable -> bool {
 
+                if (skipNextCall) {
+                    skipNextCall = false;
+                    return false;
+                }
+
                 VLOG(6) << "Retry state: stillPending = " << *stillPending << ", " << tries << "/" << maxTries << " tries";
                 bool keepTrying = tries < maxTries && *stillPending;
 
                 if (keepTrying) {
                     if (tries++ == 0) {
                         //send proper tracked call at the first ry
-                        callAsync(cxn, request, [handler = std::move(handler), stillPending] (CxnHandle cxn, auto response) {
+                        trackResponse(request, [handler = std::move(handler), stillPending] (CxnHandle cxn, auto response) {
                             *stillPending = false;
                             handler(cxn, std::move(response));
-                        });
+                        }, resent);
+                        writeRequest(cxn, request, line);
                     }
                     else {
                         //for every other try,just resend the message
-                        writeAsync(cxn, request);
+                        *resent = true;
+                        timeoutHandler();
+                        writeRequest(cxn, request, line);
                     }
                 }
                 else {//stop trying
                     if (*stillPending) {
-                        //clean up pending handler
-                        auto _ = _pending.tryPopForId(request.id);
-                        RNR_EXPECTS(_.has_value()); //this handler is supposed to exist, since *stillPending is true
+                        //clean up pending handler (unless it already timed out, see setResponseTimeout)
+                        _pending.tryPopForId(request.id);
 
+                        timeoutHandler();
                         neverRespondedHandler(); //notify callee that there was no response
                     }
                 }
@@ -8,21 +8,38 @@
 #include "JsonRpcInvoke.h"
 #include "JsonRpcBuilder.h"
 #include "JsonRpcIO.h"
+#include "JsonRpcLineWriter.h"
 #include <src/util/LockUtils.h>
-#include <deque>
+#include <vector>
 
 namespace riner { namespace jrpc {
 
         class JsonRpcUtil : private JsonRpcIO { //inherit privately instead of having a member to expose certain parts of JsonRpcIO's api via using Base::method
             using Base = JsonRpcIO;
 
-            std::deque<Method> _methods;
+            MethodTable _methods;
             HandlerMap _pending; //Note: it would make more sense to have one HandlerMap per connection (map<CxnHandle, HandlerMap>), but at this point thats not necessary yet.
 
             bool _readAsyncLoopEnabled = false;
+            std::function<void(clock::duration)> _onRoundTrip;
 
             bool hasMethod(const char *name) const;
 
+            //registers handler for request's response (wrapped to measure the round trip if onRoundTrip is set). no round
+            //trip is measured if *resent is true once the response arrives, since it may answer any of the tries
+            void trackResponse(const Message &request, ResponseHandler &&handler, std::shared_ptr<const bool> resent = nullptr);
+
+            //sends line (if not empty) or request
+            void writeRequest(CxnHandle, const Message &request, const std::string &line);
+
+            //resends request (or its preformatted line) every retryInterval until *stillPending is false or maxTries is reached,
+            //and sets *resent when it does. if firstTrySent is false the first try is sent by this function (and handler is
+            //registered for its response)
+            void retryUntilResponded(CxnHandle, Message request, std::string line, std::shared_ptr<bool> stillPending,
+                    std::shared_ptr<bool> resent, bool firstTrySent,
+                    uint32_t maxTries, milliseconds retryInterval, ResponseHandler &&handler,
+                    std::function<void()> neverRespondedHandler, std::function<void()> timeoutHandler);
+
         public:
             //expose the following functions from JsonRpcIO
             using Base::launchClient;
@@ -34,6 +51,9 @@ namespace riner { namespace jrpc {
             using Base::postAsync;
             using Base::readAsync;
             using Base::disconnectAll;
+            using Base::getIOStats;
+            using Base::serverPort;
+            using Base::setFastParserEnabled;
             //don't expose writeAsync, use callAsync instead
 
             JsonRpcIO &io() {//if you really want access you can have it
@@ -50,6 +70,16 @@ namespace riner { namespace jrpc {
             //it also means that setReadAsyncLoopEnabled(false) becomes something like a 'disconnect' call when used in a received message callback, as no further requests are enqueued
             void setReadAsyncLoopEnabled(bool val);
 
+            //onRoundTrip gets called with the time between sending a request via callAsync and receiving its response
+            //(e.g. to let a pool track its latency). calls that were resent by callAsyncRetryNTimes are not measured.
+            //Same threading restrictions as setReadAsyncLoopEnabled
+            void setOnRoundTrip(std::function<void(clock::duration)> onRoundTrip);
+
+            //response handlers of calls that got no response within timeout are dropped (default 5 minutes).
+            //the timeout applies to calls made after this function was called and should exceed the total duration of
+            //any callAsyncRetryNTimes (maxTries * retryInterval). can be called from any thread
+            void setResponseTimeout(clock::duration timeout);
+
             using IdType = int64_t;
             std::atomic<IdType> nextId = {0}; //expose id counter publicly because its really helpful
 
@@ -62,19 +92,32 @@ namespace riner { namespace jrpc {
                 }
 
                 //method overloading not supported, same-name methods are likely added after reconnect
-                _methods.erase(std::remove_if(_methods.begin(), _methods.end(), [name] (const Method &method) {
-                    return method.name() == name;
-                }), _methods.end());
+                _methods.erase(name);
 
                 //add new method
-                _methods.emplace_back(name,
-                        wrapFunc(std::forward<Func>(func), std::forward<ArgNames>(argNames)...));
-
+                _methods.emplace(name, Method{name,
+                        wrapFunc(std::forward<Func>(func), std::forward<ArgNames>(argNames)...)});
             }
 
             void callAsync(CxnHandle, Message request, ResponseHandler &&handler = responseHandlerNoop);
 
-            void callAsyncRetryNTimes(CxnHandle, Message request, uint32_t maxTries, milliseconds retryInterval, ResponseHandler &&handler, std::function<void()> neverRespondedHandler = [] () {});
+            //sends request and resends it every retryInterval until a response arrives or maxTries is reached
+            //timeoutHandler is called every time a try did not get a response within retryInterval (e.g. to detect an unresponsive pool early)
+            void callAsyncRetryNTimes(CxnHandle, Message request, uint32_t maxTries, milliseconds retryInterval, ResponseHandler &&handler,
+                    std::function<void()> neverRespondedHandler = [] () {}, std::function<void()> timeoutHandler = [] () {});
+
+            //one call of a batch passed to callAsyncRetryNTimes, the handlers have the same meaning as above
+            struct RetriedCall {
+                Message request;
+                std::string line; //optional, e.g. from a RequestLineWriter. if not empty it is sent instead of request (bypassing the json layers and their modifiers), request.id must match its id
+                ResponseHandler handler;
+                std::function<void()> neverRespondedHandler = [] () {};
+                std::function<void()> timeoutHandler = [] () {};
+            };
+
+            //same as callAsyncRetryNTimes above for every call, but the first tries of all calls are sent with a single socket write
+            //in the order of calls (e.g. to coalesce several share submissions that became ready at the same time). Must be called on the io thread
+            void callAsyncRetryNTimes(CxnHandle, std::vector<RetriedCall> calls, uint32_t maxTries, milliseconds retryInterval);
         };
 
 }}
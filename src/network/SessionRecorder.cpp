@@ -0,0 +1,107 @@
+//
+//
+
+#include "SessionRecorder.h"
+#include <src/network/LineIO.h>
+#include <src/network/JsonRpcUtil.h>
+#include <src/util/Logging.h>
+#include <sstream>
+
+namespace riner {
+
+    namespace {
+        const clock::duration flushInterval = seconds(1);
+    }
+
+    SessionRecorder::SessionRecorder(const std::string &path) {
+        auto state = _state.lock();
+        state->file.open(path, std::ios::out | std::ios::trunc);
+        if (!state->file) {
+            LOG(WARNING) << "could not open session recording file '" << path << "'";
+            return;
+        }
+        state->file << "# riner session recording v1\n";
+        state->file.flush();
+        state->last = state->lastFlush = clock::now();
+    }
+
+    void SessionRecorder::tap(LineIO &io) {
+        io.setIncomingModifier([this] (std::string &line) {
+            record(SessionRecord::inbound, line);
+        });
+        io.setOutgoingModifier([this] (std::string &line) {
+            record(SessionRecord::outbound, line);
+        });
+    }
+
+    void SessionRecorder::tap(jrpc::JsonRpcUtil &io) {
+        tap(io.io().layerBelow().layerBelow());
+    }
+
+    void SessionRecorder::record(SessionRecord::Direction direction, const std::string &line) {
+        using namespace std::chrono;
+        size_t len = line.size();
+        if (len > 0 && line[len - 1] == '\n')
+            --len;
+
+        auto state = _state.lock();
+        if (!state->file)
+            return;
+
+        //the outgoing modifier runs on the writing thread, so the clock is read under the lock to keep deltas positive
+        auto now = clock::now();
+        auto delta = duration_cast<microseconds>(now - state->last).count();
+        state->last = now;
+
+        state->file << char(direction) << ' ' << delta << ' ';
+        state->file.write(line.data(), len);
+        state->file << '\n';
+
+        if (now - state->lastFlush >= flushInterval) {
+            state->file.flush(); //keep the recording mostly complete if the process is killed
+            state->lastFlush = now;
+        }
+    }
+
+    void SessionRecorder::flush() {
+        auto state = _state.lock();
+        state->file.flush();
+        state->lastFlush = clock::now();
+    }
+
+    bool SessionRecorder::good() const {
+        return _state.lock()->file.good();
+    }
+
+    std::vector<SessionRecord> SessionRecorder::load(const std::string &path) {
+        std::vector<SessionRecord> records;
+        std::ifstream file(path);
+        if (!file) {
+            LOG(WARNING) << "could not read session recording file '" << path << "'";
+            return records;
+        }
+
+        clock::duration offset {};
+        std::string line;
+        for (size_t lineNumber = 1; std::getline(file, line); ++lineNumber) {
+            if (line.empty() || line[0] == '#')
+                continue;
+
+            //"<dir> <delta> <line>"
+            auto deltaEnd = line.find(' ', 2);
+            bool validDirection = line[0] == SessionRecord::inbound || line[0] == SessionRecord::outbound;
+            if (!validDirection || line.size() < 3 || line[1] != ' ' || deltaEnd == std::string::npos) {
+                LOG(WARNING) << "skipping malformed line " << lineNumber << " in session recording '" << path << "'";
+                continue;
+            }
+
+            int64_t delta = 0;
+            std::istringstream(line.substr(2, deltaEnd - 2)) >> delta;
+            offset += std::chrono::microseconds(delta);
+
+            records.push_back({SessionRecord::Direction(line[0]), offset, line.substr(deltaEnd + 1)});
+        }
+        return records;
+    }
+
+}
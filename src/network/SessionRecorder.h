@@ -0,0 +1,97 @@
+//
+//
+
+#pragma once
+
+#include <src/common/Chrono.h>
+#include <src/util/LockUtils.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace riner {
+
+    class LineIO;
+    namespace jrpc {
+        class JsonRpcUtil;
+    }
+
+    /**
+     * one line of a recorded session, see `SessionRecorder`
+     */
+    struct SessionRecord {
+        enum Direction : char {
+            inbound = '<', //received by the recording side (e.g. sent by the pool)
+            outbound = '>', //sent by the recording side (e.g. sent by the miner)
+        };
+
+        Direction direction;
+        clock::duration offset; //time since the start of the recording
+        std::string line; //without trailing '\n'
+    };
+
+    /**
+     * records every inbound and outbound line of an io object into a file, with timestamps, so that real pool sessions
+     * can be served back offline by a `ReplayPoolServer` (e.g. for reproducing bugs or for deterministic benchmarks).
+     *
+     * the file is plain text with one record per line: the direction ('<' inbound, '>' outbound), the microseconds
+     * since the previous record and the line itself, separated by single spaces. lines starting with '#' are comments.
+     *
+     * the recorder taps the `LineIO` layer via its modifier functions, which means that the lines are recorded exactly
+     * as they go over the wire and that the fast parsing path of the layers above is not affected.
+     * a recorder must outlive the io object it is tapping and should only be used for one connection at a time.
+     *
+     * records are buffered and written to the file at most once per second (checked whenever a line is recorded), on
+     * `flush()` and when the recorder is destroyed, so that recording doesn't add a file write to every line.
+     */
+    class SessionRecorder {
+    public:
+        /**
+         * creates (or truncates) the file at `path`. check `good()` afterwards
+         */
+        explicit SessionRecorder(const std::string &path);
+
+        /**
+         * installs incoming and outgoing modifiers on `io` that record every line.
+         * like the modifiers themselves this must be called before `io` is launched, and replaces any modifiers
+         * that were set on that layer before
+         */
+        void tap(LineIO &io);
+
+        /**
+         * convenience overload that taps the `LineIO` layer of a `JsonRpcUtil`
+         */
+        void tap(jrpc::JsonRpcUtil &io);
+
+        /**
+         * appends a record, thread safe. a trailing '\n' of `line` is not recorded
+         */
+        void record(SessionRecord::Direction direction, const std::string &line);
+
+        /**
+         * writes all buffered records to the file, thread safe
+         */
+        void flush();
+
+        /**
+         * @return whether the file could be opened and all records were written successfully up to the last flush
+         */
+        bool good() const;
+
+        /**
+         * reads a recording that was written by a `SessionRecorder`, malformed lines are skipped with a warning
+         * @return the records in the order they were recorded, empty if the file couldn't be read
+         */
+        static std::vector<SessionRecord> load(const std::string &path);
+
+    private:
+        struct State {
+            std::ofstream file; //buffers the records between flushes
+            clock::time_point last;
+            clock::time_point lastFlush;
+        };
+
+        LockGuarded<State> _state;
+    };
+
+}
@@ -10,18 +10,36 @@
 namespace riner {
     using namespace asio;
 
-    Socket::Socket(asio::io_service &ioService, bool isClient)
+    Socket::Socket(asio::io_service &ioService, bool isClient, IoUring *ioUring)
     : _var(TcpSocket{ioService})
-    , _isClient(isClient) {
+    , _isClient(isClient)
+    , _ioUring(ioUring) {
     }
 
-    Socket::Socket(asio::io_service &ioService, bool isClient, const SslDesc &desc)
+#ifdef HAS_OPENSSL
+    namespace {
+        //index of the SSL_CTX ex data that points to the SslContext
+        int contextIndex() {
+            static int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+            return index;
+        }
+
+        //index of the SSL ex data that points to the host (a key of SslContext::_sessions) the session belongs to
+        int sessionHostIndex() {
+            static int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+            return index;
+        }
+    }
+#endif
+
+    SslContext::SslContext(const SslDesc &desc, bool isClient)
     : _isClient(isClient) {
 #ifdef HAS_OPENSSL
         using c = ssl::context;
         error_code err;
 
-        c ctx {c::tls};
+        auto ctxPtr = make_unique<c>(c::tls);
+        c &ctx = *ctxPtr;
 
         uint64_t options = 0ULL;
 
@@ -104,7 +122,74 @@ namespace riner {
             LOG(ERROR) << server_client_str << "error setting options for tls socket ctx. asio error message: " << err.message();
         }
 
-        auto &sock = _var.emplace<SslTcpSocket>(ioService, ctx);
+        SSL_CTX *native = ctx.native_handle();
+        if (_isClient) {
+            //sessions are stored by onNewSession, which also works for tls 1.3 where they arrive after the handshake
+            SSL_CTX_set_session_cache_mode(native, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+            SSL_CTX_sess_set_new_cb(native, &SslContext::onNewSession);
+            SSL_CTX_set_ex_data(native, contextIndex(), this); //app data is used by asio itself
+        }
+        else {
+            static const unsigned char sessionIdContext[] = "riner";
+            SSL_CTX_set_session_id_context(native, sessionIdContext, sizeof(sessionIdContext) - 1);
+            SSL_CTX_set_session_cache_mode(native, SSL_SESS_CACHE_SERVER);
+        }
+
+        _ctx = std::move(ctxPtr);
+#endif
+    }
+
+    SslContext::~SslContext() {
+#ifdef HAS_OPENSSL
+        for (auto &pair : *_sessions.lock()) {
+            if (pair.second) {
+                SSL_SESSION_free(pair.second);
+            }
+        }
+#endif
+    }
+
+#ifdef HAS_OPENSSL
+    void SslContext::prepareClientSession(SSL *ssl, const std::string &host) {
+        auto sessions = _sessions.lock();
+        auto it = sessions->emplace(host, nullptr).first; //map keys have stable addresses
+        SSL_set_ex_data(ssl, sessionHostIndex(), const_cast<std::string *>(&it->first));
+        if (it->second) {
+            SSL_set_session(ssl, it->second); //does not take ownership
+        }
+    }
+
+    int SslContext::onNewSession(SSL *ssl, SSL_SESSION *session) {
+        auto self = static_cast<SslContext *>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), contextIndex()));
+        auto host = static_cast<const std::string *>(SSL_get_ex_data(ssl, sessionHostIndex()));
+        if (!self || !host) {
+            return 0; //session is not kept
+        }
+
+        //keep a copy, since openssl marks the connection's own session as not resumable if the connection is closed
+        //without a tls shutdown (which is how BaseIO closes connections)
+        SSL_SESSION *copy = SSL_SESSION_dup(session);
+        if (!copy) {
+            return 0;
+        }
+
+        auto sessions = self->_sessions.lock();
+        SSL_SESSION *&stored = (*sessions)[*host];
+        if (stored) {
+            SSL_SESSION_free(stored);
+        }
+        stored = copy;
+        return 0; //session itself is not kept
+    }
+#endif
+
+    Socket::Socket(asio::io_service &ioService, shared_ptr<SslContext> context)
+    : _sslContext(std::move(context))
+    , _isClient(_sslContext->isClient()) {
+#ifdef HAS_OPENSSL
+        if (auto ctx = _sslContext->get()) {
+            _var.emplace<SslTcpSocket>(ioService, *ctx);
+        }
 #endif
     }
 
@@ -114,6 +199,10 @@ namespace riner {
             // Perform SSL handshake and verify the remote host's
             // certificate.
             if (_isClient) {
+                if (host) {
+                    _sslContext->prepareClientSession(sock.native_handle(), host.value());
+                }
+
                 //sock.set_verify_callback(ssl::rfc2818_verification(host.value()));
 
                 sock.set_verify_callback([host] (bool preverified, ssl::verify_context &ctx) -> bool {
@@ -165,8 +254,28 @@ namespace riner {
         return *result;
     }
 
+    void Socket::close() {
+#ifdef RINER_IO_URING
+        if (_ioUring && mpark::get_if<TcpSocket>(&_var)) {
+            _ioUring->cancel(tcpStream().native_handle()); //asio doesn't know about the reads and writes of the ring
+        }
+#endif
+        asio::error_code ignored;
+        tcpStream().close(ignored);
+    }
+
     bool Socket::isClient() const {
         return _isClient;
     }
 
+    bool Socket::sslSessionReused() {
+        bool reused = false;
+#ifdef HAS_OPENSSL
+        visit<SslTcpSocket>(_var, [&] (SslTcpSocket &sock) {
+            reused = SSL_session_reused(sock.native_handle()) == 1;
+        });
+#endif
+        return reused;
+    }
+
 }
\ No newline at end of file
@@ -9,7 +9,13 @@
 #include <src/common/Variant.h>
 #include <src/network/SslDesc.h>
 #include <src/util/Copy.h>
+#include <src/util/LockUtils.h>
 #include <src/common/Assert.h>
+#include <map>
+
+#ifdef RINER_IO_URING
+#include <src/network/IoUring.h>
+#endif
 
 #ifdef HAS_OPENSSL
 #include <lib/asio/asio/include/asio/ssl/stream.hpp>
@@ -36,6 +42,46 @@ namespace riner {
 
     using asio::ip::tcp;
 
+    class IoUring;
+
+    /**
+     * The ssl context (certificates, verification, options) that is shared by all sockets a BaseIO creates with the same
+     * SslDesc, so that it is set up once and not for every connection. Sharing it also allows resuming TLS sessions:
+     * servers accept session ids/tickets of the context, and clients keep the last session per host so that a reconnect
+     * can do an abbreviated handshake instead of a full one.
+     */
+    class SslContext {
+        bool _isClient;
+#ifdef HAS_OPENSSL
+        unique_ptr<asio::ssl::context> _ctx; //nullptr if the setup failed
+        LockGuarded<std::map<std::string, SSL_SESSION *>> _sessions; //last session per host (owned), for clients
+
+        static int onNewSession(SSL *, SSL_SESSION *);
+#endif
+
+    public:
+        SslContext(const SslDesc &, bool isClient); //does nothing if OpenSSL is not available
+        ~SslContext();
+
+        DELETE_COPY_AND_MOVE(SslContext);
+
+        bool isClient() const {
+            return _isClient;
+        }
+
+#ifdef HAS_OPENSSL
+        asio::ssl::context *get() {
+            return _ctx.get();
+        }
+
+        /**
+         * makes the upcoming client handshake on `ssl` resume the last session with `host` (if any), and remembers
+         * the session that results from it for the next handshake
+         */
+        void prepareClientSession(SSL *ssl, const std::string &host);
+#endif
+    };
+
     class Socket {
         using TcpSocket = tcp::socket;
 
@@ -45,12 +91,14 @@ namespace riner {
         class None {None() = default;};
         using SslTcpSocket = None;
 #endif
+        shared_ptr<SslContext> _sslContext; //referenced by the ssl stream, so it must be declared before _var
         variant<nullptr_t, TcpSocket, SslTcpSocket> _var {nullptr}; //TODO: replace with old school object oriented virtual stuff!
         bool _isClient = false;
+        IoUring *_ioUring = nullptr; //if set, the reads and writes of the regular tcp socket go through it instead of asio
 
     public:
-        explicit Socket(asio::io_service &, bool isClient); //constructs a regular tcp socket
-        Socket(asio::io_service &, bool isClient, const SslDesc &); //constructs a ssl enabled tcp socket or does nothing if OpenSSL is not available
+        Socket(asio::io_service &, bool isClient, IoUring *ioUring = nullptr); //constructs a regular tcp socket, ioUring must outlive it
+        Socket(asio::io_service &, shared_ptr<SslContext>); //constructs a ssl enabled tcp socket or does nothing if OpenSSL is not available or the context setup failed
         Socket() = default;
 
         operator bool() const {
@@ -69,7 +117,53 @@ namespace riner {
 
         SOCKET_FNCT(async_read_until);
         SOCKET_FNCT(async_read);
-        SOCKET_FNCT(async_write);
+
+        /**
+         * writes all buffers, see asio's `async_write`
+         */
+        template<class ConstBufferSequence, class Handler>
+        void async_write(const ConstBufferSequence &buffers, Handler &&handler) {
+            if (auto s = mpark::get_if<TcpSocket>(&_var)) {
+#ifdef RINER_IO_URING
+                if (_ioUring) {
+                    std::vector<asio::const_buffer> sequence(asio::buffer_sequence_begin(buffers), asio::buffer_sequence_end(buffers));
+                    _ioUring->asyncSend(s->native_handle(), sequence, std::forward<Handler>(handler));
+                    return;
+                }
+#endif
+                asio::async_write(*s, buffers, std::forward<Handler>(handler));
+            }
+            else {
+#ifdef HAS_OPENSSL
+                asio::async_write(mpark::get<SslTcpSocket>(_var), buffers, std::forward<Handler>(handler));
+#else
+                throw mpark::bad_variant_access();
+#endif
+            }
+        }
+
+        /**
+         * reads whatever is available (at least one byte) into buffer, see asio's `async_read_some`
+         */
+        template<class MutableBuffer, class Handler>
+        void async_read_some(const MutableBuffer &buffer, Handler &&handler) {
+            if (auto s = mpark::get_if<TcpSocket>(&_var)) {
+#ifdef RINER_IO_URING
+                if (_ioUring) {
+                    _ioUring->asyncRecv(s->native_handle(), buffer, std::forward<Handler>(handler));
+                    return;
+                }
+#endif
+                s->async_read_some(buffer, std::forward<Handler>(handler));
+            }
+            else {
+#ifdef HAS_OPENSSL
+                mpark::get<SslTcpSocket>(_var).async_read_some(buffer, std::forward<Handler>(handler));
+#else
+                throw mpark::bad_variant_access();
+#endif
+            }
+        }
 
         /**
          * if initialized as a ssl socket, performs ssl handshake, otherwise nothing. use handler to continue
@@ -77,6 +171,17 @@ namespace riner {
         using HandshakeFunc = std::function<void(const asio::error_code &)>;
 
         void asyncHandshakeOrNoop(HandshakeFunc handler, optional<std::string> host = {});
+
+        /**
+         * closes the socket, so that pending reads and writes complete with asio::error::operation_aborted
+         */
+        void close();
+
+        /**
+         * @return whether the completed ssl handshake resumed a previous session instead of doing a full handshake.
+         * false for non-ssl sockets
+         */
+        bool sslSessionReused();
     };
 
 }
@@ -0,0 +1,57 @@
+//
+//
+
+#include "DuplicateShareFilter.h"
+#include <src/common/Assert.h>
+#include <algorithm>
+#include <cctype>
+
+namespace riner {
+
+    DuplicateShareFilter::DuplicateShareFilter(size_t capacity)
+            : _capacity(capacity) {
+        RNR_EXPECTS(capacity > 0);
+    }
+
+    bool DuplicateShareFilter::insert(uint64_t key) {
+        if (!_keys.insert(key).second) {
+            return false;
+        }
+        _insertionOrder.push_back(key);
+
+        if (_insertionOrder.size() > _capacity) {
+            _keys.erase(_insertionOrder.front());
+            _insertionOrder.pop_front();
+        }
+        return true;
+    }
+
+    uint64_t DuplicateShareFilter::makeKey(uint64_t nonce, const std::vector<uint32_t> &pow) {
+        //64 bit FNV-1a over the nonce and all pow words
+        const uint64_t prime = 0x100000001b3ULL;
+        uint64_t hash = 0xcbf29ce484222325ULL;
+
+        auto add = [&] (uint64_t value, size_t bytes) {
+            for (size_t i = 0; i < bytes; ++i) {
+                hash ^= (value >> (8 * i)) & 0xff;
+                hash *= prime;
+            }
+        };
+
+        add(nonce, sizeof(nonce));
+        for (uint32_t word : pow) {
+            add(word, sizeof(word));
+        }
+        return hash;
+    }
+
+    bool DuplicateShareFilter::isDuplicateRejection(const std::string &errorMessage) {
+        //pools word it differently ("Duplicate share", "duplicate", "share is duplicated"...)
+        std::string lower = errorMessage;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [] (unsigned char c) {
+            return std::tolower(c);
+        });
+        return lower.find("duplicate") != std::string::npos;
+    }
+
+}
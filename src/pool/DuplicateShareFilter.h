@@ -0,0 +1,58 @@
+//
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace riner {
+
+    /**
+     * @brief bounded set of the shares that were already submitted for one PoolJob. A PoolImpl checks every solution
+     * against the filter of its job before building the submit message, so that the same share is never sent twice
+     * (e.g. if two work items of a job end up scanning the same nonces after their extraNonce wrapped around).
+     * Pools reject such shares as duplicates and may penalize the miner for it.
+     * Shares are identified by a 64 bit key (e.g. the nonce, or a hash of nonce and proof of work). Once `capacity`
+     * keys are stored, the oldest ones are forgotten.
+     * Not thread-safe, PoolImpls use it on their io thread only.
+     */
+    class DuplicateShareFilter {
+    public:
+        explicit DuplicateShareFilter(size_t capacity = 4096);
+
+        /**
+         * inserts key into the filter
+         * @return true if the key was not part of the filter yet, false if it is a duplicate
+         */
+        bool insert(uint64_t key);
+
+        size_t size() const {
+            return _keys.size();
+        }
+
+        /**
+         * convenience function for creating a key out of a nonce and a proof of work (e.g. cuckoo cycle edges)
+         */
+        static uint64_t makeKey(uint64_t nonce, const std::vector<uint32_t> &pow);
+
+        /**
+         * submits are resent if the pool doesn't respond in time, so a pool may reject a resent share as a duplicate
+         * of the earlier try that it did receive. PoolImpls use this to count such rejections as duplicates instead of
+         * rejected shares.
+         * @param errorMessage the error message of a rejected submit
+         * @return whether the pool rejected the share as a duplicate
+         */
+        static bool isDuplicateRejection(const std::string &errorMessage);
+
+    private:
+        const size_t _capacity;
+        std::unordered_set<uint64_t> _keys;
+        std::deque<uint64_t> _insertionOrder; //for evicting the oldest key
+    };
+
+}
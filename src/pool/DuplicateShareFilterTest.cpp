@@ -0,0 +1,44 @@
+
+#include <src/pool/DuplicateShareFilter.h>
+
+#include <gtest/gtest.h>
+
+namespace riner {
+namespace {
+
+TEST(DuplicateShareFilter, DetectsDuplicates) {
+    DuplicateShareFilter filter;
+    EXPECT_TRUE(filter.insert(42));
+    EXPECT_TRUE(filter.insert(43));
+    EXPECT_FALSE(filter.insert(42));
+    EXPECT_EQ(filter.size(), 2);
+}
+
+TEST(DuplicateShareFilter, ForgetsOldestKeysWhenFull) {
+    DuplicateShareFilter filter {3};
+    for (uint64_t key = 0; key < 4; ++key) {
+        EXPECT_TRUE(filter.insert(key));
+    }
+    EXPECT_EQ(filter.size(), 3);
+    EXPECT_FALSE(filter.insert(3));
+    EXPECT_TRUE(filter.insert(0)); //was evicted by key 3
+}
+
+TEST(DuplicateShareFilter, KeyDependsOnNonceAndPow) {
+    std::vector<uint32_t> pow {1, 2, 3};
+    std::vector<uint32_t> otherPow {1, 2, 4};
+
+    EXPECT_EQ(DuplicateShareFilter::makeKey(7, pow), DuplicateShareFilter::makeKey(7, pow));
+    EXPECT_NE(DuplicateShareFilter::makeKey(7, pow), DuplicateShareFilter::makeKey(8, pow));
+    EXPECT_NE(DuplicateShareFilter::makeKey(7, pow), DuplicateShareFilter::makeKey(7, otherPow));
+}
+
+TEST(DuplicateShareFilter, RecognizesDuplicateRejections) {
+    EXPECT_TRUE(DuplicateShareFilter::isDuplicateRejection("Duplicate share"));
+    EXPECT_TRUE(DuplicateShareFilter::isDuplicateRejection("share is duplicated"));
+    EXPECT_FALSE(DuplicateShareFilter::isDuplicateRejection("Low difficulty share"));
+    EXPECT_FALSE(DuplicateShareFilter::isDuplicateRejection(""));
+}
+
+} // namespace
+} // riner
@@ -0,0 +1,118 @@
+//
+//
+
+#pragma once
+
+#include <src/util/Copy.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+namespace riner {
+
+    /**
+     * @brief generation counter shared between a job queue and all Work/WorkSolution objects created from it
+     * The queue takes the ids of its jobs from here (see expireAll()), so the latest job id only ever grows. Every
+     * Work object remembers the id of the job it was made from, so checking for expiry is a single relaxed atomic
+     * load (no weak_ptr locking, no virtual call into the Pool).
+     * The token outlives the queue if Work objects are still around, in which case it is closed and all
+     * work is considered expired and invalid.
+     * Threads can also wait for the expiry of a job id, they are woken up as soon as the queue pushes a newer job.
+     */
+    class ExpiryToken {
+        static constexpr size_t cacheLineSize = 64;
+
+        //the counter is read by every algorithm thread, keep it on its own cache line
+        char _padBefore[cacheLineSize];
+        std::atomic<int64_t> _latestJobId {0};
+        char _padAfter[cacheLineSize - sizeof(std::atomic<int64_t>)];
+
+        std::atomic_bool _closed {false};
+        std::atomic<int64_t> _firstValidJobId {0}; //jobs before this id were cleared, see invalidateBefore()
+        mutable std::atomic<int> _waiters {0};
+        mutable std::mutex _mutex;
+        mutable std::condition_variable _cv;
+
+        void notifyWaiters() {
+            if (_waiters.load() > 0) { //only pay for the lock if someone is actually waiting
+                { std::lock_guard<std::mutex> lock(_mutex); }
+                _cv.notify_all();
+            }
+        }
+
+    public:
+        ExpiryToken() = default;
+        DELETE_COPY_AND_MOVE(ExpiryToken);
+
+        /**
+         * @return id of the most recent job, all other job ids are expired
+         */
+        inline int64_t latestJobId() const {
+            return _latestJobId.load(std::memory_order_relaxed);
+        }
+
+        inline bool isExpired(int64_t jobId) const {
+            return latestJobId() != jobId;
+        }
+
+        /**
+         * @return whether jobId was cleared (e.g. by a job with clean flag), so that its solutions are not accepted anymore
+         */
+        inline bool isInvalid(int64_t jobId) const {
+            return jobId < _firstValidJobId.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @return whether the owning queue does not exist anymore
+         */
+        inline bool isClosed() const {
+            return _closed.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief declare all job ids before jobId invalid. The pool may still keep their PoolJobs alive to judge
+         * late solutions, but algorithms should stop working on them
+         */
+        void invalidateBefore(int64_t jobId) {
+            _firstValidJobId.store(jobId);
+        }
+
+        /**
+         * @brief mark all job ids handed out so far as expired
+         * @return the new latest job id
+         */
+        int64_t expireAll() {
+            int64_t newId = _latestJobId.fetch_add(1) + 1;
+            notifyWaiters();
+            return newId;
+        }
+
+        /**
+         * @brief called when the owning queue is destroyed, expires and invalidates everything
+         */
+        void close() {
+            _closed.store(true);
+            expireAll();
+        }
+
+        /**
+         * blocks until jobId expires or the timeout is reached
+         * @return whether jobId is expired
+         */
+        template<class Duration>
+        bool waitForExpiry(int64_t jobId, Duration timeout) const {
+            if (isExpired(jobId))
+                return true;
+            std::unique_lock<std::mutex> lock(_mutex);
+            ++_waiters;
+            bool expired = _cv.wait_for(lock, timeout, [&] {
+                return _latestJobId.load() != jobId; //seq_cst, pairs with the _waiters check in notifyWaiters()
+            });
+            --_waiters;
+            return expired;
+        }
+    };
+
+}
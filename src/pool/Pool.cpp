@@ -2,9 +2,13 @@
 #include "Pool.h"
 #include "PoolEthash.h"
 #include "PoolGrin.h"
+#include <cmath>
+#include <algorithm>
 
 namespace riner {
 
+    constexpr uint32_t Pool::maxConsecutiveStrikes;
+
     Pool::Pool(PoolConstructionArgs args)
             : constructionArgs(std::move(args)) {
     }
@@ -13,6 +17,7 @@ namespace riner {
         w->_this = w;
         w->_poolImplName = poolImplName;
         w->_powType = powType;
+        w->_powTypeId = powTypeIdFromString(powType);
     }
 
     void Pool::setConnected(bool connected) {
@@ -21,20 +26,117 @@ namespace riner {
             if (connected) {
                 clearJobs();
                 records.resetInterval();
+                _faulty = false; //a fresh connection that delivered a job is no longer faulty
+                _consecutiveStrikes = 0;
                 _connected = true;
             }
             else {
                 _connected = false;
                 records.resetInterval();
             }
-            onStateChange->notify_all();
+            notifyStateChange();
         }
     }
 
     void Pool::setDisabled(bool disabled) {
         if (disabled != _disabled.exchange(disabled) && onStateChange) {
-            onStateChange->notify_all();
+            notifyStateChange();
+        }
+    }
+
+    void Pool::notifyStateChange() {
+        if (!onStateChange)
+            return;
+        if (onStateChangeMutex) {
+            std::lock_guard<std::mutex> lock(*onStateChangeMutex);
+        }
+        onStateChange->notify_all();
+    }
+
+    void Pool::reportFault(const std::string &reason) {
+        _latestFaultTime = clock::now();
+        if (!_faulty.exchange(true)) {
+            LOG(WARNING) << "pool '" << getName() << "' is faulty: " << reason;
+            notifyStateChange();
+        }
+    }
+
+    void Pool::reportTimeout(const std::string &reason) {
+        uint32_t strikes = ++_consecutiveStrikes;
+        if (strikes >= maxConsecutiveStrikes) {
+            reportFault(reason + " (" + std::to_string(strikes) + " times in a row)");
+        }
+        else {
+            VLOG(2) << "pool '" << getName() << "': " << reason;
+        }
+    }
+
+    void Pool::reportRoundTrip(clock::duration rtt) {
+        const size_t minSamples = 8; //don't judge before the smoothed rtt is meaningful
+        const double minOutlierSecs = 2; //rtt spikes below this are never considered a fault
+        double sample = std::chrono::duration<double>(rtt).count();
+        bool outlier = false;
+        {
+            std::lock_guard<std::mutex> lock(_rttMutex);
+            if (_rttSamples >= minSamples) {
+                double threshold = _smoothedRttSecs + 8 * _rttVarianceSecs;
+                outlier = sample > std::max(threshold, minOutlierSecs);
+            }
+
+            if (outlier) {
+                //outliers are kept out of the estimate, so that the following ones of a streak still stand out.
+                //if the streak makes the pool faulty, the estimate starts over in case the pool got slower for good
+                if (_consecutiveStrikes + 1 >= maxConsecutiveStrikes) {
+                    _rttSamples = 0;
+                }
+            }
+            else {
+                if (_rttSamples == 0) {
+                    _smoothedRttSecs = sample;
+                    _rttVarianceSecs = sample / 2;
+                }
+                else {
+                    //same weights as TCP (RFC 6298)
+                    _rttVarianceSecs = 0.75 * _rttVarianceSecs + 0.25 * std::abs(_smoothedRttSecs - sample);
+                    _smoothedRttSecs = 0.875 * _smoothedRttSecs + 0.125 * sample;
+                }
+                ++_rttSamples;
+            }
+        }
+
+        if (outlier) {
+            reportTimeout("round trip time of " + std::to_string(sample) + "s is far above the usual");
+        }
+        else {
+            _consecutiveStrikes = 0;
+        }
+    }
+
+    optional<Pool::clock::duration> Pool::getSmoothedRoundTrip() const {
+        std::lock_guard<std::mutex> lock(_rttMutex);
+        if (_rttSamples == 0) {
+            return nullopt;
+        }
+        return std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(_smoothedRttSecs));
+    }
+
+    void Pool::reportJobArrived(bool cleanFlag) {
+        if (!cleanFlag) {
+            return;
         }
+        std::lock_guard<std::mutex> lock(_jobTimesMutex);
+        if (_recentCleanJobTimes.size() < recentCleanJobCount) {
+            _recentCleanJobTimes.push_back(clock::now());
+        }
+        else {
+            _recentCleanJobTimes[_nextCleanJobIndex] = clock::now();
+            _nextCleanJobIndex = (_nextCleanJobIndex + 1) % recentCleanJobCount;
+        }
+    }
+
+    std::vector<Pool::clock::time_point> Pool::getRecentCleanJobTimes() const {
+        std::lock_guard<std::mutex> lock(_jobTimesMutex);
+        return _recentCleanJobTimes;
     }
 
     void Pool::setActive(bool active) {
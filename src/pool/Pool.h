@@ -11,9 +11,20 @@
 #include <string>
 #include <list>
 #include <atomic>
+#include <mutex>
+#include <vector>
 
 namespace riner {
 
+    /**
+     * decides which shares of outdated jobs a PoolImpl still submits (see "stale_share_policy" in the config)
+     */
+    enum class StaleSharePolicy {
+        submitStale,  //submit shares of every job that is still known
+        dropCleaned,  //drop shares of jobs that the pool invalidated by sending a newer job with clean flag
+        dropOutdated, //only submit shares of the latest job
+    };
+
     /**
      * @brief Args passed into every Pool subclass ctor
      * If you want to add args to every pool's ctor, add them to this struct instead
@@ -27,6 +38,8 @@ namespace riner {
         std::string username;
         std::string password;
         SslDesc sslDesc;
+        StaleSharePolicy staleSharePolicy = StaleSharePolicy::dropCleaned;
+        std::string recordSessionFile; //if not empty, the pool's connection gets recorded into this file, see SessionRecorder
     };
 
     /**
@@ -112,6 +125,21 @@ namespace riner {
         std::atomic_bool _active {true};
         std::atomic_bool _connected {false};
         std::atomic_bool _disabled {false};
+        std::atomic_bool _faulty {false};
+        std::atomic<clock::time_point> _latestFaultTime = {clock::now() - std::chrono::hours(24 * 365)};
+        std::atomic<uint32_t> _consecutiveStrikes {0}; //timeouts and rtt outliers since the last normal response
+
+        //round trip time estimation for reportRoundTrip(), similar to TCP's smoothed rtt
+        mutable std::mutex _rttMutex;
+        double _smoothedRttSecs = 0;
+        double _rttVarianceSecs = 0;
+        size_t _rttSamples = 0;
+
+        //arrival times of the most recent clean jobs (ring buffer), see reportJobArrived()
+        static constexpr size_t recentCleanJobCount = 8;
+        mutable std::mutex _jobTimesMutex;
+        std::vector<clock::time_point> _recentCleanJobTimes;
+        size_t _nextCleanJobIndex = 0;
 
     protected:
 
@@ -119,8 +147,17 @@ namespace riner {
         std::weak_ptr<Pool> _this; //assigned in Registry's initFunc lambda, which creates the shared_ptr, which is ok because even if the Pool ctor starts iothreads which use _this before it is assigned, the mechanisms that use it are nullptr safe.
         std::string _poolImplName = ""; //assigned in Registry...
         std::string _powType = ""; //assigned in Registry...
+        PowTypeId _powTypeId = 0; //powTypeIdFromString(_powType), assigned together with it
         PoolRecords records;
         std::shared_ptr<std::condition_variable> onStateChange;
+        std::shared_ptr<std::mutex> onStateChangeMutex; //the mutex the waiting thread uses with onStateChange
+
+        /**
+         * @brief notifies onStateChange (if set)
+         * the mutex is acquired before notifying, so that the notification cannot get lost between the waiting
+         * thread's predicate check and its wait
+         */
+        void notifyStateChange();
 
         /**
          * @brief writes the connected flag of the pool, which indicates whether a connection is established and whether it received a job yet
@@ -135,6 +172,44 @@ namespace riner {
          */
         void setDisabled(bool disabled);
 
+        /**
+         * @brief report that the connection is not usable anymore, even though it was not closed (yet)
+         * e.g. a share submission timed out. The PoolSwitcher is woken up immediately and switches away from a faulty
+         * active pool, then it reconnects the faulty pool via onDeclaredDead().
+         * The fault is cleared once the pool is connected again (see setConnected)
+         * @param reason human readable reason, for logging
+         */
+        void reportFault(const std::string &reason);
+
+        /**
+         * timeouts and rtt outliers in a row (without a normal response in between) after which a fault is reported
+         */
+        static constexpr uint32_t maxConsecutiveStrikes = 3;
+
+        /**
+         * @brief report that a try of a request (e.g. a share submission) did not get a response in time
+         * A single slow response is tolerated, a fault is only reported once `maxConsecutiveStrikes` timeouts or
+         * rtt outliers (see reportRoundTrip) happened in a row
+         * @param reason human readable reason, for logging
+         */
+        void reportTimeout(const std::string &reason);
+
+        /**
+         * @brief report the round trip time of a request/response pair (e.g. mining.submit and its response)
+         * Once a few samples are known, an rtt that is way above the smoothed rtt counts like a timeout (see
+         * reportTimeout), an rtt within the usual range resets the count
+         * @param rtt time between sending the request and receiving the response
+         */
+        void reportRoundTrip(clock::duration rtt);
+
+        /**
+         * @brief report that a job was received from the pool (call it where the job is pushed into the WorkQueue)
+         * arrival times of clean jobs (e.g. new blocks) are compared between the pools of a PoolSwitcher to find out
+         * which pool learns about new blocks late
+         * @param cleanFlag whether the job replaces all previous jobs
+         */
+        void reportJobArrived(bool cleanFlag);
+
     public:
         Pool() = delete;
 
@@ -172,9 +247,12 @@ namespace riner {
 
         /**
          * sets the onStateChange condition variable, so that the calling thread can be notified later
+         * @param cv condition variable that gets notified on state changes
+         * @param mutex mutex that the waiting thread holds while checking its predicate
          */
-        inline void setOnStateChangeCv(std::shared_ptr<std::condition_variable> cv) {
-            onStateChange = cv;
+        inline void setOnStateChangeCv(std::shared_ptr<std::condition_variable> cv, std::shared_ptr<std::mutex> mutex) {
+            onStateChange = std::move(cv);
+            onStateChangeMutex = std::move(mutex);
         }
 
         /**
@@ -255,7 +333,7 @@ namespace riner {
         unique_ptr<WorkT> tryGetWork() {
             auto work = tryGetWorkImpl();
             if (work) {
-                RNR_EXPECTS(work->powType == WorkT::getPowType());
+                RNR_EXPECTS(work->powTypeId == PowTypeIdOf<WorkT>::value);
                 return static_unique_ptr_cast<WorkT>(std::move(work));
             }
             return nullptr;
@@ -271,7 +349,7 @@ namespace riner {
          */
         template<class WorkSolutionT>
         void submitSolution(unique_ptr<WorkSolutionT> result) {
-            RNR_EXPECTS(result != nullptr && result->powType == WorkSolutionT::getPowType());
+            RNR_EXPECTS(result != nullptr && result->powTypeId == PowTypeIdOf<WorkSolutionT>::value);
 
             submitSolutionImpl(static_unique_ptr_cast<WorkSolutionT>(std::move(result)));
         }
@@ -297,6 +375,31 @@ namespace riner {
             return _disabled;
         }
 
+        /**
+         * @return whether a fault was reported since the pool was last connected, see reportFault()
+         */
+        inline bool isFaulty() const {
+            return _faulty;
+        }
+
+        /**
+         * @return smoothed round trip time of the pool's requests (see reportRoundTrip()) or nullopt if there was no
+         * response yet
+         */
+        optional<clock::duration> getSmoothedRoundTrip() const;
+
+        /**
+         * @return arrival times of the most recent clean jobs (see reportJobArrived()), in no particular order
+         */
+        std::vector<clock::time_point> getRecentCleanJobTimes() const;
+
+        /**
+         * @return the timestamp of the most recent reportFault() call
+         */
+        inline clock::time_point getLatestFaultTime() const {
+            return _latestFaultTime;
+        }
+
         /**
          * @return string name of the Pool subclass (aka PoolImpl) as it can be passed to makePool
          */
@@ -313,6 +416,13 @@ namespace riner {
             return _powType;
         }
 
+        /**
+         * @return id of getPowType(), see PowType.h
+         */
+        inline PowTypeId getPowTypeId() const {
+            return _powTypeId;
+        }
+
         ~Pool() override = default;
 
         DELETE_COPY_AND_MOVE(Pool);
@@ -19,6 +19,13 @@ namespace riner {
             //If you use another kind of network io, you have to forward it to that
         }
 
+        //tell the Pool base class how long the pool takes to respond to our requests (login, submit...), so that the PoolSwitcher
+        //can react to a pool that gets way slower than usual, or prefer the fastest pool.
+        //like all io settings this is done once here, before the io thread starts calling onConnected
+        io.setOnRoundTrip([this] (auto rtt) {
+            reportRoundTrip(std::chrono::duration_cast<clock::duration>(rtt));
+        });
+
         tryConnect();
         //make sure tryConnect() is the final thing you do in this ctor.
         //things that get initialized after the io operations started are not guaranteed to be ready when
@@ -199,7 +206,6 @@ namespace riner {
 
             //this lambda will get called if we get a response, either the share was accepted or rejected
             auto onResponse = [this, difficulty = job->difficulty] (CxnHandle cxn, jrpc::Message response) {
-                //
                 records.reportShare(difficulty, response.isResultTrue(), false);
                 std::string acceptedStr = response.isResultTrue() ? "accepted" : "rejected";
                 LOG(INFO) << "share with id '" << response.id << "' got " << acceptedStr << " by '" << getName() << "'";
@@ -211,11 +217,18 @@ namespace riner {
                 LOG(INFO) << "share with id " << shareId << " got discarded after pool did not respond multiple times";
             };
 
+            //this lambda gets called every time a try did not get a response in time.
+            //a few timeouts in a row make the pool faulty, so that the PoolSwitcher switches to a backup pool right away,
+            //instead of waiting until this pool is declared dead
+            auto onTimeout = [this] () {
+                reportTimeout("share submission timed out");
+            };
+
             //this call below tries to send the `submit` request.
             //if there is no response, after the specified amount of seconds, it will try to send again (up to maxTries times)
             //if there is still no response after the last try, the onNeverResponded lambda gets called.
             auto maxTries = 5;
-            io.callAsyncRetryNTimes(_cxn, submit, maxTries, seconds(5), onResponse, onNeverResponded);
+            io.callAsyncRetryNTimes(_cxn, submit, maxTries, seconds(5), onResponse, onNeverResponded, onTimeout);
 
         });
     }
@@ -247,6 +260,7 @@ namespace riner {
         //add job to job queue
 
         LOG(INFO) << "we have a new job! (and therefore a new WorkTemplate)";
+        reportJobArrived(shouldClean); //lets the PoolSwitcher compare how early the pools send new blocks
         queue.pushJob(std::move(job), shouldClean);
         //now that the job is pushed, `queue`'s background thread will every now and then call
         //job->makeWork() to produce enough work objects.
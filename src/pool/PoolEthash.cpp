@@ -8,6 +8,7 @@
 #include <chrono>
 #include <random>
 #include <functional>
+#include <algorithm>
 
 #include <asio.hpp>
 #include <src/common/Chrono.h>
@@ -81,18 +82,29 @@ namespace riner {
         bool cleanFlag = jparams.at(4);
         Bytes<32> jobTarget;
         const auto &jobId = jparams.at(0).get<std::string>();
-        auto job = std::make_unique<EthashStratumJob>(_this, jobId);
+        auto job = std::make_shared<EthashStratumJob>(_this, jobId);
 
-        job->workTemplate.extraNonce = static_cast<uint32_t>(std::random_device()()); //generate random number for extranonce
-        HexString(jparams[1]).getBytes(job->workTemplate.header);
-        HexString(jparams[2]).getBytes(job->workTemplate.seedHash);
+        job->extraNonce = static_cast<uint32_t>(std::random_device()()); //generate random number for extranonce
+        HexString(jparams[1]).getBytes(job->jobData.header);
+        HexString(jparams[2]).getBytes(job->jobData.seedHash);
         HexString(jparams[3]).swapByteOrder().getBytes(jobTarget);
-        job->workTemplate.setDifficultiesAndTargets(jobTarget);
+        job->jobData.setDifficultiesAndTargets(jobTarget);
 
-        //workTemplate->epoch is calculated in EthashStratumJob::makeWork()
+        //jobData.epoch is calculated in EthashStratumJob::makeWork()
         //so that not too much time is spent on this thread.
 
+        job->sequence = ++latestJobSequence;
+        if (cleanFlag) {
+            latestCleanJobSequence = job->sequence;
+        }
+
+        recentJobs.push_front(job);
+        if (recentJobs.size() > maxRecentJobs) {
+            recentJobs.pop_back();
+        }
+
         setConnected(true);
+        reportJobArrived(cleanFlag);
         queue.pushJob(std::move(job), cleanFlag);
     }
 
@@ -120,44 +132,130 @@ namespace riner {
     void PoolEthashStratum::submitSolutionImpl(unique_ptr<WorkSolution> resultBase) {
 
         auto result = static_unique_ptr_cast<WorkSolutionEthash>(std::move(resultBase));
+        queuedShares.lock()->push_back({std::move(result), clock::now()});
+
+        //build and send the submit messages on the tcp thread. only one flush is posted at a time, shares that are
+        //queued until it runs are sent along with it
+        if (!flushPosted.exchange(true)) {
+            io.postAsync([this] {
+                flushQueuedShares();
+            });
+        }
+    }
 
-        //build and send submitMessage on the tcp thread
+    bool PoolEthashStratum::isDroppedAsStale(const EthashStratumJob &job) const {
+        switch (constructionArgs.staleSharePolicy) {
+            case StaleSharePolicy::submitStale:
+                return false;
+            case StaleSharePolicy::dropCleaned:
+                return job.sequence < latestCleanJobSequence;
+            case StaleSharePolicy::dropOutdated:
+                return job.sequence < latestJobSequence;
+        }
+        return false;
+    }
+
+    void PoolEthashStratum::flushQueuedShares() {
+        flushPosted = false; //shares that are queued from now on need another flush
+
+        std::vector<QueuedShare> shares;
+        std::swap(shares, *queuedShares.lock());
 
-        io.postAsync([this, result = std::move(result)] {
+        struct ReadyShare {
+            QueuedShare share;
+            std::shared_ptr<const EthashStratumJob> job;
+        };
+        std::vector<ReadyShare> ready;
+        ready.reserve(shares.size());
 
-            auto job = result->tryGetJobAs<EthashStratumJob>();
+        for (auto &share : shares) {
+            auto &result = *share.solution;
+
+            auto job = result.tryGetJobAs<EthashStratumJob>();
             if (!job) {
-                LOG(INFO) << "work result cannot be submitted because it is stale";
-                return; //work is stale
+                records.reportOrphanedShare(result.jobDifficulty);
+                LOG(INFO) << "work result cannot be submitted because its job is not known anymore";
+                continue;
+            }
+
+            if (isDroppedAsStale(*job)) {
+                records.reportStaleShare(result.jobDifficulty);
+                LOG(INFO) << "work result of job '" << job->jobId << "' is not submitted because it is stale";
+                continue;
+            }
+
+            if (!job->submittedNonces.insert(result.nonce)) {
+                records.reportShare(result.jobDifficulty, false, true);
+                LOG(INFO) << "share with nonce 0x" << HexString(toBytesWithBigEndian(result.nonce)).str() << " was already submitted for job '" << job->jobId << "', dropping duplicate";
+                continue;
             }
 
+            ready.push_back({std::move(share), std::move(job)});
+        }
+
+        if (ready.empty()) {
+            return;
+        }
+
+        //shares of the latest job first, the backlog of older jobs after that
+        std::stable_sort(ready.begin(), ready.end(), [] (const ReadyShare &a, const ReadyShare &b) {
+            return a.job->sequence > b.job->sequence;
+        });
+
+        std::vector<jrpc::JsonRpcUtil::RetriedCall> calls;
+        calls.reserve(ready.size());
+
+        for (auto &r : ready) {
+            auto &result = *r.share.solution;
             uint32_t shareId = io.nextId++;
 
-            jrpc::Message submit = jrpc::RequestBuilder{}
-                .id(shareId)
+            jrpc::JsonRpcUtil::RetriedCall call;
+            call.request = jrpc::RequestBuilder{}.id(shareId).method("mining.submit").done(); //for response tracking
+            call.line = submitWriter.id(shareId)
                 .method("mining.submit")
                 .param(constructionArgs.username)
-                .param(job->jobId)
-                .param("0x" + HexString(toBytesWithBigEndian(result->nonce)).str()) //nonce must be big endian
-                .param("0x" + HexString(result->header).str())
-                .param("0x" + HexString(result->mixHash).str())
+                .param(r.job->jobId)
+                .paramHex(toBytesWithBigEndian(result.nonce)) //nonce must be big endian
+                .paramHex(result.header)
+                .paramHex(result.mixHash)
                 .done();
 
-            auto onResponse = [this, difficulty = result->jobDifficulty] (CxnHandle cxn, jrpc::Message response) {
+            auto resent = std::make_shared<bool>(false); //set by timeoutHandler, only accessed on the io thread
+            call.handler = [this, difficulty = result.jobDifficulty, resent] (CxnHandle cxn, jrpc::Message response) {
+                auto error = response.getIfError();
+                if (*resent && error && DuplicateShareFilter::isDuplicateRejection(error->message)) {
+                    //the pool received an earlier try, whose response was lost or came too late
+                    records.reportShare(difficulty, false, true);
+                    LOG(INFO) << "share with id '" << response.id << "' was resent and already received by '" << getName() << "'";
+                    return;
+                }
                 records.reportShare(difficulty, response.isResultTrue(), false);
                 std::string acceptedStr = response.isResultTrue() ? "accepted" : "rejected";
                 LOG(INFO) << "share with id '" << response.id << "' got " << acceptedStr << " by '" << getName() << "'";
             };
 
             //this handler gets called if there was no response after the last try
-            auto onNeverResponded = [shareId] () {
+            call.neverRespondedHandler = [shareId] () {
                 // TODO: Shall we add dedicated statistics for this?
                 LOG(INFO) << "share with id " << shareId << " got discarded after pool did not respond multiple times";
             };
 
-            io.callAsyncRetryNTimes(_cxn, submit, 5, seconds(5), onResponse, onNeverResponded);
+            //this handler gets called every time a try did not get a response in time
+            call.timeoutHandler = [this, resent] () {
+                *resent = true;
+                reportTimeout("share submission timed out");
+            };
+
+            calls.push_back(std::move(call));
+        }
 
+        auto oldest = std::min_element(ready.begin(), ready.end(), [] (const ReadyShare &a, const ReadyShare &b) {
+            return a.share.queuedTime < b.share.queuedTime;
         });
+        auto queuedFor = std::chrono::duration_cast<milliseconds>(clock::now() - oldest->share.queuedTime);
+        VLOG(2) << "submitting " << calls.size() << " share(s) with one write, queued for up to " << queuedFor.count() << "ms";
+
+        io.callAsyncRetryNTimes(_cxn, std::move(calls), 5, seconds(5));
     }
 
     void PoolEthashStratum::tryConnect() {
@@ -178,6 +276,14 @@ namespace riner {
         if (args.sslDesc.client) {
             io.io().enableSsl(args.sslDesc);
         }
+        if (!args.recordSessionFile.empty()) {
+            recorder = make_unique<SessionRecorder>(args.recordSessionFile);
+            recorder->tap(io);
+        }
+        //track response times of all requests (subscribe, authorize, submit), see Pool::reportRoundTrip
+        io.setOnRoundTrip([this] (auto rtt) {
+            reportRoundTrip(std::chrono::duration_cast<clock::duration>(rtt));
+        });
         tryConnect();
     }
 
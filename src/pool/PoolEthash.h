@@ -3,14 +3,18 @@
 
 #include <src/pool/WorkQueue.h>
 #include <src/pool/WorkEthash.h>
+#include <src/pool/DuplicateShareFilter.h>
 #include <src/config/Config.h>
 #include <src/util/LockUtils.h>
 #include <src/common/Pointers.h>
 #include <queue>
 #include <future>
 #include <list>
+#include <deque>
+#include <vector>
 #include <atomic>
 #include <src/network/JsonRpcUtil.h>
+#include <src/network/SessionRecorder.h>
 
 namespace riner {
 
@@ -19,12 +23,19 @@ namespace riner {
      */
     struct EthashStratumJob : public PoolJob {
         const std::string jobId;
-        WorkEthash workTemplate;
+        WorkEthash::JobData jobData; //filled on the io thread before the job is pushed to the queue
+        uint32_t extraNonce = 0;
+        uint64_t sequence = 0; //counts the jobs of a PoolEthashStratum (newer jobs have a higher sequence), set on the io thread
+        mutable DuplicateShareFilter submittedNonces; //accessed on the io thread only
 
         std::unique_ptr<Work> makeWork() override {
-            workTemplate.setEpoch();
-            workTemplate.extraNonce++;
-            return make_unique<WorkEthash>(workTemplate);
+            if (!sharedJobData) {
+                jobData.setEpoch();
+                sharedJobData = std::make_shared<const WorkEthash::JobData>(jobData);
+            }
+            auto work = make_unique<WorkEthash>(sharedJobData);
+            work->extraNonce = ++extraNonce;
+            return work;
         }
 
         ~EthashStratumJob() override = default;
@@ -36,6 +47,7 @@ namespace riner {
 
     private:
         static const uint32_t uniqueNonce;
+        std::shared_ptr<const WorkEthash::JobData> sharedJobData; //created on the first makeWork() call
     };
 
 
@@ -50,7 +62,7 @@ namespace riner {
         void expireJobs() override;
         void clearJobs() override;
 
-    private:
+    protected:
         WorkQueue queue;
 
         void onDeclaredDead() override;
@@ -62,12 +74,33 @@ namespace riner {
         void submitSolutionImpl(unique_ptr<WorkSolution> resultBase) override;
 
         void onConnected(CxnHandle);
+        unique_ptr<SessionRecorder> recorder; //optional, must outlive io
         jrpc::JsonRpcUtil io {"PoolEthash"};
 
         CxnHandle _cxn; //modified only on IO thread
         bool acceptMiningNotify = false; //modified only on IO thread
+        uint64_t latestJobSequence = 0; //modified only on IO thread
+        uint64_t latestCleanJobSequence = 0; //sequence of the latest job with clean flag, modified only on IO thread
+
+        //the queue forgets all jobs on a clean flag, so the latest jobs are kept alive in here (newest first) until
+        //isDroppedAsStale() has decided about their late shares. modified only on IO thread
+        std::deque<std::shared_ptr<const EthashStratumJob>> recentJobs;
+        static constexpr size_t maxRecentJobs = 8;
 
         void onMiningNotify (const nl::json &j);
+
+        //submitted shares are queued and then sent in batches on the io thread, so that shares which become ready
+        //while the io thread is busy are coalesced into a single socket write
+        struct QueuedShare {
+            unique_ptr<WorkSolutionEthash> solution;
+            clock::time_point queuedTime;
+        };
+        LockGuarded<std::vector<QueuedShare>> queuedShares;
+        std::atomic_bool flushPosted {false}; //whether a flushQueuedShares() call is already posted to the io thread
+        jrpc::RequestLineWriter submitWriter; //renders mining.submit requests, used on the io thread only
+
+        void flushQueuedShares();
+        bool isDroppedAsStale(const EthashStratumJob &job) const; //applies constructionArgs.staleSharePolicy
     };
 
 }
@@ -0,0 +1,199 @@
+
+#include <src/pool/PoolEthash.h>
+#include <src/network/JsonRpcBuilder.h>
+#include <src/network/JsonRpcUtil.h>
+#include <src/util/Barrier.h>
+#include <src/util/Logging.h>
+
+#include <gtest/gtest.h>
+
+namespace riner {
+namespace {
+
+using namespace jrpc;
+using namespace std::chrono;
+using namespace std::chrono_literals;
+using RB = RequestBuilder;
+
+const std::string zeroHash = "0x" + std::string(64, '0'); //seed hash of epoch 0
+const std::string header = "0x" + std::string(63, '0') + "1";
+const std::string target = "0x00000000ffff" + std::string(52, '0');
+
+/**
+ * PoolEthashStratum that lets the test hold its io thread, so that shares can be queued while the io thread is busy
+ */
+class HoldablePoolEthashStratum : public PoolEthashStratum {
+public:
+    using PoolEthashStratum::PoolEthashStratum;
+
+    //the io thread doesn't run anything else until `until` becomes ready
+    void holdIoThread(std::shared_future<void> until) {
+        io.postAsync([until] {
+            until.wait();
+        });
+    }
+
+    IOStats getIOStats() const {
+        return io.getIOStats();
+    }
+};
+
+/**
+ * stand-in stratum pool that sends jobs on request and records the job ids of the submitted shares in arrival order
+ */
+class StandInEthashPool {
+public:
+    std::vector<std::string> submittedJobIds; //only accessed on the io thread until `allSubmitted` is unblocked
+    std::vector<std::string> submittedNonces;
+    Barrier authorized;
+    Barrier allSubmitted;
+    clock::time_point lastSubmitTime;
+
+    explicit StandInEthashPool(size_t expectedSubmits) {
+        io.addMethod("mining.subscribe", [] () {
+            return true;
+        });
+        io.addMethod("mining.authorize", [this] () {
+            authorized.unblock();
+            return true;
+        });
+        io.addMethod("mining.submit", [this, expectedSubmits] (nl::json params) {
+            submittedJobIds.push_back(params.at(1));
+            submittedNonces.push_back(params.at(2));
+            if (submittedJobIds.size() == expectedSubmits) {
+                lastSubmitTime = clock::now();
+                allSubmitted.unblock();
+            }
+            return true;
+        });
+        io.launchServer(0, [this] (CxnHandle cxn) { //any free port
+            _cxn = cxn;
+            io.setReadAsyncLoopEnabled(true);
+            io.readAsync(cxn);
+        });
+    }
+
+    uint16_t port() const {
+        return io.serverPort();
+    }
+
+    void sendJob(const std::string &jobId, bool clean) {
+        io.postAsync([this, jobId, clean] {
+            io.callAsync(*_cxn, RB{}.method("mining.notify")
+                    .param(jobId).param(header).param(zeroHash).param(target).param(clean).done());
+        });
+    }
+
+private:
+    optional<CxnHandle> _cxn; //only accessed on the io thread
+    JsonRpcUtil io{"stand-in ethash pool"};
+};
+
+//returns work of the job with the given id, or nullptr if it didn't arrive in time
+unique_ptr<WorkEthash> waitForWorkOfJob(Pool &pool, const std::string &jobId) {
+    auto deadline = clock::now() + 10s;
+    while (clock::now() < deadline) {
+        if (auto work = pool.tryGetWork<WorkEthash>()) {
+            auto job = std::static_pointer_cast<const EthashStratumJob>(work->tryGetJob());
+            if (job && job->jobId == jobId)
+                return work;
+        }
+    }
+    return nullptr;
+}
+
+unique_ptr<WorkSolutionEthash> makeShare(const WorkEthash &work, uint64_t nonce) {
+    auto share = work.makeWorkSolution<WorkSolutionEthash>();
+    share->nonce = nonce;
+    return share;
+}
+
+}
+
+TEST(PoolEthashStratum, QueuedSharesGoOutInOneWriteLatestJobFirst) {
+    StandInEthashPool server{4};
+
+    auto pool = std::make_shared<HoldablePoolEthashStratum>(PoolConstructionArgs{"127.0.0.1", server.port(), "user", "x", SslDesc{}});
+    Pool::postInit(pool, "PoolEthashStratum", "ethash");
+    ASSERT_NE(server.authorized.wait_for(10s), std::future_status::timeout);
+
+    server.sendJob("a", true);
+    auto workA = waitForWorkOfJob(*pool, "a");
+    ASSERT_TRUE(workA);
+    server.sendJob("b", false);
+    auto workB = waitForWorkOfJob(*pool, "b");
+    ASSERT_TRUE(workB);
+
+    //queue shares of both jobs, interleaved, while the io thread can't flush them
+    std::promise<void> release;
+    pool->holdIoThread(release.get_future().share());
+    auto statsBefore = pool->getIOStats();
+
+    pool->submitSolution(makeShare(*workA, 1));
+    pool->submitSolution(makeShare(*workB, 2));
+    pool->submitSolution(makeShare(*workA, 3));
+    pool->submitSolution(makeShare(*workB, 4));
+
+    auto releaseTime = clock::now();
+    release.set_value();
+    ASSERT_NE(server.allSubmitted.wait_for(10s), std::future_status::timeout);
+
+    LOG(INFO) << "4 queued shares reached the pool after " << duration<double, std::milli>(server.lastSubmitTime - releaseTime).count() << "ms";
+
+    auto stats = pool->getIOStats();
+    EXPECT_EQ(stats.writeOps - statsBefore.writeOps, 1);
+    EXPECT_EQ(stats.messagesWritten - statsBefore.messagesWritten, 4);
+
+    //latest job first, order within a job is preserved
+    EXPECT_EQ(server.submittedJobIds, (std::vector<std::string>{"b", "b", "a", "a"}));
+    EXPECT_EQ(server.submittedNonces, (std::vector<std::string>{
+        "0x0000000000000002", "0x0000000000000004", "0x0000000000000001", "0x0000000000000003"}));
+}
+
+//submits a share of job "a" after job "b" cleaned it, followed by a share of "b", and returns the job ids that reached the pool
+std::vector<std::string> submitShareOfCleanedJob(StaleSharePolicy policy, PoolRecords::Data &records) {
+    const size_t expectedSubmits = policy == StaleSharePolicy::submitStale ? 2 : 1;
+    StandInEthashPool server{expectedSubmits};
+
+    PoolConstructionArgs args{"127.0.0.1", server.port(), "user", "x", SslDesc{}};
+    args.staleSharePolicy = policy;
+    auto pool = std::make_shared<HoldablePoolEthashStratum>(args);
+    Pool::postInit(pool, "PoolEthashStratum", "ethash");
+    EXPECT_NE(server.authorized.wait_for(10s), std::future_status::timeout);
+
+    server.sendJob("a", true);
+    auto workA = waitForWorkOfJob(*pool, "a");
+    EXPECT_TRUE(workA);
+    server.sendJob("b", true);
+    auto workB = waitForWorkOfJob(*pool, "b");
+    EXPECT_TRUE(workB);
+    if (!workA || !workB)
+        return {};
+
+    EXPECT_FALSE(workA->valid()); //algorithms stop working on a cleaned job, even though the pool still knows it
+    EXPECT_TRUE(workB->valid());
+
+    //hold the io thread, so that both shares are flushed together
+    std::promise<void> release;
+    pool->holdIoThread(release.get_future().share());
+    pool->submitSolution(makeShare(*workA, 1));
+    pool->submitSolution(makeShare(*workB, 2));
+    release.set_value();
+    EXPECT_NE(server.allSubmitted.wait_for(10s), std::future_status::timeout);
+
+    records = pool->readRecords();
+    return server.submittedJobIds;
+}
+
+TEST(PoolEthashStratum, StaleSharePolicyDecidesAboutSharesOfCleanedJobs) {
+    PoolRecords::Data records;
+
+    EXPECT_EQ(submitShareOfCleanedJob(StaleSharePolicy::submitStale, records), (std::vector<std::string>{"b", "a"}));
+    EXPECT_EQ(records.staleShares.mean.getTotal(), 0);
+
+    EXPECT_EQ(submitShareOfCleanedJob(StaleSharePolicy::dropCleaned, records), (std::vector<std::string>{"b"}));
+    EXPECT_EQ(records.staleShares.mean.getTotal(), 1);
+    EXPECT_EQ(records.orphanedShares.mean.getTotal(), 0);
+}
+
+}
@@ -63,14 +63,15 @@ namespace riner {
         auto jobId = jparams.at("job_id").get<int64_t>();
         auto job = std::make_unique<GrinStratumJob>(_this, jobId, height);
 
-        job->workTemplate.difficulty = jparams.at("difficulty");
-        job->workTemplate.nonce = random_.getUniform<uint64_t>();
+        job->jobData.difficulty = jparams.at("difficulty");
+        job->nonce = random_.getUniform<uint64_t>();
 
         HexString powHex(jparams.at("pre_pow"));
-        job->workTemplate.prePow.resize(powHex.sizeBytes());
-        powHex.getBytes(job->workTemplate.prePow);
+        job->jobData.prePow.resize(powHex.sizeBytes());
+        powHex.getBytes(job->jobData.prePow);
 
         setConnected(true);
+        reportJobArrived(cleanFlag);
         queue.pushJob(std::move(job), cleanFlag);
     }
 
@@ -101,25 +102,39 @@ namespace riner {
                 return; //work has expired
             }
 
-            nl::json pow;
-            for(uint32_t i: solution->pow) {
-                pow.push_back(i);
+            if (!job->submittedSolutions.insert(DuplicateShareFilter::makeKey(solution->nonce, solution->pow))) {
+                records.reportShare(1., false, true);
+                LOG(INFO) << "solution with nonce " << solution->nonce << " was already submitted for job " << job->jobId << ", dropping duplicate";
+                return;
             }
 
-            jrpc::Message submit = jrpc::RequestBuilder{}.id(io.nextId++)
+            int64_t shareId = io.nextId++;
+
+            jrpc::JsonRpcUtil::RetriedCall submit;
+            submit.request = jrpc::RequestBuilder{}.id(shareId).method("submit").done(); //for response tracking
+            //the line bypasses the json layer's outgoing modifier, so the id is written as a string right away
+            submit.line = submitWriter.idAsString(shareId)
                     .method("submit")
-                    .param("edge_bits", solution->edgeBits())
+                    .param("edge_bits", int64_t(solution->edgeBits()))
                     .param("height", job->height)
                     .param("job_id", job->jobId)
                     .param("nonce", solution->nonce)
-                    .param("pow", pow)
+                    .param("pow", solution->pow)
                     .done();
 
-            auto onResponse = [this] (CxnHandle cxn, jrpc::Message res) {
+            auto resent = std::make_shared<bool>(false); //set by timeoutHandler, only accessed on the io thread
+            submit.handler = [this, resent] (CxnHandle cxn, jrpc::Message res) {
                 std::string idStr = "<no id>";
                 if (!res.id.is_null()) {
                     idStr = std::to_string(res.id.get<int64_t>());
                 }
+                auto error = res.getIfError();
+                if (*resent && error && DuplicateShareFilter::isDuplicateRejection(error->message)) {
+                    //the pool received an earlier try, whose response was lost or came too late
+                    records.reportShare(1., false, true);
+                    LOG(INFO) << "share with id '" << idStr << "' was resent and already received by '" << getName() << "'";
+                    return;
+                }
                 bool accepted = false;
                 if (auto result = res.getIfResult()) {
                     if (*result == "ok") {
@@ -140,14 +155,19 @@ namespace riner {
                 }
             };
 
-            auto onNeverResponded = [submit] () {
+            submit.neverRespondedHandler = [shareId] () {
                 //this handler gets called if there was no response after the last try
-                auto idStr = submit.id.empty() ? submit.id.get<std::string>() : "<no id>";
+                LOG(INFO) << "share with id " << shareId << " got discarded after pool did not respond multiple times";
+            };
 
-                LOG(INFO) << "share with id " << idStr << " got discarded after pool did not respond multiple times";
+            submit.timeoutHandler = [this, resent] () {
+                *resent = true;
+                reportTimeout("share submission timed out");
             };
 
-            io.callAsyncRetryNTimes(_cxn, submit, 5, std::chrono::seconds(5), onResponse, onNeverResponded);
+            std::vector<jrpc::JsonRpcUtil::RetriedCall> calls;
+            calls.push_back(std::move(submit));
+            io.callAsyncRetryNTimes(_cxn, std::move(calls), 5, std::chrono::seconds(5));
         });
     }
 
@@ -195,6 +215,14 @@ namespace riner {
         if (args.sslDesc.client) {
             io.io().enableSsl(args.sslDesc);
         }
+        if (!args.recordSessionFile.empty()) {
+            recorder = make_unique<SessionRecorder>(args.recordSessionFile);
+            recorder->tap(io);
+        }
+        //track response times of all requests (login, submit), see Pool::reportRoundTrip
+        io.setOnRoundTrip([this] (auto rtt) {
+            reportRoundTrip(std::chrono::duration_cast<clock::duration>(rtt));
+        });
         tryConnect();
     }
 
@@ -5,7 +5,9 @@
 #include "WorkCuckoo.h"
 
 #include <src/pool/WorkEthash.h>
+#include <src/pool/DuplicateShareFilter.h>
 #include <src/network/JsonRpcUtil.h>
+#include <src/network/SessionRecorder.h>
 #include <src/config/Config.h>
 #include <src/util/LockUtils.h>
 #include <src/util/Random.h>
@@ -19,19 +21,27 @@ namespace riner {
 
         int64_t jobId;
         int64_t height;
-        WorkCuckatoo31 workTemplate;
+        WorkCuckatoo31::JobData jobData; //filled on the io thread before the job is pushed to the queue
+        uint64_t nonce = 0;
+        mutable DuplicateShareFilter submittedSolutions; //keys made of nonce and pow, accessed on the io thread only
 
         std::unique_ptr<Work> makeWork() override {
-            workTemplate.nonce++;
-            return std::make_unique<WorkCuckatoo31>(workTemplate);
+            if (!sharedJobData) {
+                sharedJobData = std::make_shared<const WorkCuckatoo31::JobData>(std::move(jobData));
+            }
+            auto work = std::make_unique<WorkCuckatoo31>(sharedJobData);
+            work->nonce = ++nonce;
+            return work;
         }
 
         explicit GrinStratumJob(const std::weak_ptr<Pool> &pool, int64_t id, int64_t height)
                 : PoolJob(pool)
                 , jobId(id)
-                , height(height)
-                , workTemplate() {
+                , height(height) {
         }
+
+    private:
+        std::shared_ptr<const WorkCuckatoo31::JobData> sharedJobData; //created on the first makeWork() call
     };
 
     class PoolGrinStratum : public Pool {
@@ -56,7 +66,9 @@ namespace riner {
         LazyWorkQueue queue;
 
         Random random_;
+        unique_ptr<SessionRecorder> recorder; //optional, must outlive io
         jrpc::JsonRpcUtil io{"PoolGrinStratum"};
+        jrpc::RequestLineWriter submitWriter; //renders submit requests, used on the io thread only
         CxnHandle _cxn; //connection to submit shares to (set on mining notify)
 
         int64_t currentHeight = -1;
@@ -16,9 +16,11 @@ namespace riner {
 
         RNR_EXPECTS(!powType.empty());
         _powType = powType;
+        _powTypeId = powTypeIdFromString(powType);
         _poolImplName = powType + "-PoolSwitcher";
 
         onStateChange = std::make_shared<std::condition_variable>();
+        onStateChangeMutex = std::make_shared<std::mutex>();
         periodicAliveCheckTask = std::async(std::launch::async, [this, powType] () {
             SetThreadNameStream{} << "poolswitcher " << powType;
             VLOG(6) << "alive-check thread started";
@@ -28,7 +30,7 @@ namespace riner {
 
     PoolSwitcher::~PoolSwitcher() {
         {
-            std::lock_guard<std::mutex> lock(mut);
+            std::lock_guard<std::mutex> lock(*onStateChangeMutex);
             shutdown = true;
         }
         VLOG(6) << "shutting down poolswitcher " << _powType << " thread";
@@ -44,10 +46,10 @@ namespace riner {
 
             bool was_active = false;
             auto _poolUid = poolUid;
-            //copy shared_ptr to active pool and access pool through copy
+            //load the active pool once and access it through the local pointer
             //because the active pool might change at any time
             if (auto pool = active_pool.get()) {
-                was_active = pool->isConnected() && !pool->isDisabled();
+                was_active = pool->isConnected() && !pool->isDisabled() && !pool->isFaulty();
                 _poolUid = pool->poolUid;
             }
             activePoolIndex = aliveCheckAndMaybeSwitch(activePoolIndex);
@@ -58,23 +60,37 @@ namespace riner {
             }
 
             //notification for waiting tryGetWorkImpl() calls
-            onStateChange->notify_all();
+            notifyStateChange();
 
-            //use condition vairable to wait, so the wait can be interrupted on shutdown
-            std::unique_lock<std::mutex> lock(mut);
-            onStateChange->wait_for(lock, checkInterval, [this, was_active] {
+            //sleep until the next periodic check, but wake up exactly when the active pool would be declared dead
+            //because of silence instead of up to checkInterval later
+            auto now = clock::now();
+            auto wakeupTime = now + checkInterval;
+            if (auto pool = active_pool.get()) {
+                auto deadTime = pool->getLastKnownAliveTime() + durUntilDeclaredDead + std::chrono::milliseconds(1);
+                if (deadTime > now) {
+                    wakeupTime = std::min(wakeupTime, deadTime);
+                }
+            }
+
+            //use condition variable to wait, so the wait can be interrupted on shutdown and by events of the pools
+            //(disconnect, disabled, reported faults, see Pool::notifyStateChange), which makes failover event driven
+            std::unique_lock<std::mutex> lock(*onStateChangeMutex);
+            onStateChange->wait_until(lock, wakeupTime, [this, was_active] {
                 bool wakeup = shutdown;
                 if (wakeup) {
                     return true;
                 }
                 auto pool = active_pool.get();
                 if (was_active && pool && !pools_changed) {
-                    wakeup = pool->isDisabled() || !pool->isConnected();
+                    wakeup = pool->isDisabled() || !pool->isConnected() || pool->isFaulty();
+                    //a hot standby pool failed, the next backup pool needs to be activated
+                    wakeup |= countUsableStandbyPools() < usableStandbyPools;
                 }
                 else {
                     auto pools_lock_guard = _pools.readLock();
                     for (const auto pool : *pools_lock_guard) {
-                        if ((wakeup = pool->isConnected() && !pool->isDisabled())) {
+                        if ((wakeup = pool->isConnected() && !pool->isDisabled() && !pool->isFaulty())) {
                             break;
                         }
                     }
@@ -111,7 +127,13 @@ namespace riner {
             bool was_dead{}; //pool was dead during last check
             bool now_dead{}; //pool is now dead in this check
             bool disabled{};
+            bool faulty{}; //a fault was reported (e.g. submit timeout), see Pool::reportFault
             bool connected{};
+            optional<double> latencyScore; //only calculated if latencyAwareSelection is enabled
+
+            bool usable() const {
+                return connected && !now_dead && !disabled && !faulty;
+            }
         };
         std::vector<Info> poolInfos{pools.size()};
 
@@ -122,24 +144,86 @@ namespace riner {
             poolInfos[i].was_dead = pools[i]->isDead();
             poolInfos[i].now_dead = now - pools[i]->getLastKnownAliveTime() > durUntilDeclaredDead;
             poolInfos[i].disabled = pools[i]->isDisabled();
+            poolInfos[i].faulty = pools[i]->isFaulty();
             poolInfos[i].connected = pools[i]->isConnected();
         }
 
-        //decide new active pool
+        if (latencyAwareSelection) {
+            std::vector<std::vector<clock::time_point>> jobTimes(pools.size());
+            for (size_t i = 0; i < pools.size(); ++i) {
+                jobTimes[i] = pools[i]->getRecentCleanJobTimes();
+            }
+            for (Info &p : poolInfos) {
+                p.latencyScore = latencyScoreSecs(*pools[p.index], averageJobLagSecs(p.index, jobTimes));
+            }
+        }
+
+        //decide new active pool: the first usable one, or the usable one with the lowest latency score
+        const Info *chosen = nullptr;
+        const Info *prev = nullptr;
         for (const Info &p : poolInfos) {
-            if (p.connected && !p.now_dead && !p.disabled) {
-                bool is_another_pool = prev_pool && prev_pool->poolUid != p.uid;
-                pool_switched = is_another_pool || !prev_pool;
-                new_pool = pools[p.index];
-                activePoolIndex = p.index;
-                active_pool.set(new_pool);
-                if (is_another_pool) {
-                    prev_pool->expireJobs();
+            if (prev_pool && prev_pool->poolUid == p.uid) {
+                prev = &p;
+            }
+            if (!p.usable()) {
+                continue;
+            }
+            if (!chosen) {
+                chosen = &p;
+                if (!latencyAwareSelection) {
+                    break; //first one that is not dead is chosen
                 }
-                break; //first one that is not dead is chosen
+            }
+            else if (p.latencyScore && (!chosen->latencyScore || *p.latencyScore < *chosen->latencyScore)) {
+                chosen = &p;
             }
         }
 
+        if (chosen && prev && prev != chosen && prev->usable() && prev->latencyScore && chosen->latencyScore) {
+            //hysteresis: only switch away from a working pool if the other one is clearly faster
+            const double minRelativeGain = 0.2;
+            const double minAbsoluteGainSecs = 0.005;
+            if (*prev->latencyScore < *chosen->latencyScore * (1 + minRelativeGain) + minAbsoluteGainSecs) {
+                chosen = prev;
+            }
+        }
+
+        if (chosen) {
+            bool is_another_pool = prev_pool && prev_pool->poolUid != chosen->uid;
+            pool_switched = is_another_pool || !prev_pool;
+            new_pool = pools[chosen->index].get();
+            activePoolIndex = chosen->index;
+            active_pool.set(pools[chosen->index]);
+            //a split mining pool keeps handing out work after losing the active role, so its jobs stay valid
+            if (is_another_pool && (!splitMining || getSplitWeight(*prev_pool) == 0)) {
+                prev_pool->expireJobs();
+            }
+        }
+
+        //keep the active pool and the next standbyPoolCount usable pools connected (hot standby), deactivate the rest.
+        //pools of higher priority than the active pool stay active, so that they can take over once they are usable again
+        size_t standbys = 0;
+        bool activeSeen = false;
+        for (const Info &p : poolInfos) {
+            bool usable = p.usable();
+            bool isActivePool = new_pool && new_pool->poolUid == p.uid;
+            bool keepActive = !new_pool || !activeSeen || standbys < standbyPoolCount
+                    || getSplitWeight(*pools[p.index]) > 0; //split mining pools are always in use
+
+            if (isActivePool) {
+                activeSeen = true;
+            }
+            else if (activeSeen && keepActive && usable) {
+                ++standbys;
+            }
+
+            if (pools[p.index]->isActive() != keepActive) {
+                LOG(INFO) << (keepActive ? "activating" : "deactivating") << " backup pool #" << p.index << " (" << pools[p.index]->getName() << ")";
+                pools[p.index]->setActive(keepActive);
+            }
+        }
+        usableStandbyPools = standbys;
+
         //declare/undeclare pools as dead, close connections of disabled pools
         for (const Info &p : poolInfos) {
             pools[p.index]->setDead(p.now_dead);
@@ -147,6 +231,10 @@ namespace riner {
                 LOG(INFO) << "pool '" << pools[p.index]->getName() << "' disabled. kill connection.";
                 pools[p.index]->onDeclaredDead();
             }
+            else if (p.faulty && p.connected) {
+                LOG(INFO) << "pool '" << pools[p.index]->getName() << "' is faulty. reconnecting.";
+                pools[p.index]->onDeclaredDead();
+            }
         }
 
         {//write descriptive logs (collapse this scope if needed)
@@ -159,6 +247,9 @@ namespace riner {
 
             if (pool_switched) {
                 LOG(INFO) << "Pool #" << activePoolIndex << " (" << new_pool->getName() << ") chosen as new active pool";
+                if (chosen->latencyScore) {
+                    LOG(INFO) << "latency score of pool #" << activePoolIndex << ": " << *chosen->latencyScore * 1000 << "ms";
+                }
             }
 
             for (const Info &p : poolInfos) {
@@ -190,16 +281,130 @@ namespace riner {
         return activePoolIndex;
     }
 
+    size_t PoolSwitcher::countUsableStandbyPools() const {
+        auto active = active_pool.get();
+        size_t count = 0;
+        for (const auto &pool : *_pools.readLock()) {
+            if (pool.get() != active && pool->isActive() && pool->isConnected() && !pool->isDisabled() && !pool->isFaulty()) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    optional<double> PoolSwitcher::latencyScoreSecs(const Pool &pool, double jobLagSecs) const {
+        auto rtt = pool.getSmoothedRoundTrip();
+        if (!rtt) {
+            return nullopt;
+        }
+        const double minAcceptedRatio = 0.05; //keep the score finite
+        double acceptedRatio = std::max(1 - pool.readRecords().rejectedRatio(), minAcceptedRatio);
+        return (std::chrono::duration<double>(*rtt).count() + jobLagSecs) / acceptedRatio;
+    }
+
+    double PoolSwitcher::averageJobLagSecs(size_t index, const std::vector<std::vector<clock::time_point>> &jobTimes) {
+        const auto sameBlockWindow = std::chrono::seconds(5); //clean jobs of different pools that arrive this close are considered the same block
+        double lagSum = 0;
+        size_t matched = 0;
+
+        for (auto time : jobTimes[index]) {
+            auto earliest = time;
+            bool isMatched = false;
+            for (size_t j = 0; j < jobTimes.size(); ++j) {
+                if (j == index) {
+                    continue;
+                }
+                for (auto other : jobTimes[j]) {
+                    if (other > time - sameBlockWindow && other < time + sameBlockWindow) {
+                        isMatched = true;
+                        earliest = std::min(earliest, other);
+                    }
+                }
+            }
+            if (isMatched) {
+                lagSum += std::chrono::duration<double>(time - earliest).count();
+                ++matched;
+            }
+        }
+        return matched ? lagSum / matched : 0;
+    }
+
+    uint32_t PoolSwitcher::getSplitWeight(const Pool &pool) const {
+        if (auto schedule = splitSchedule.get()) {
+            for (auto &entry : schedule->pools) {
+                if (entry.pool == &pool) {
+                    return entry.weight;
+                }
+            }
+        }
+        return 0;
+    }
+
+    bool PoolSwitcher::isUsableForSplit(const Pool &pool) {
+        return pool.isConnected() && !pool.isDisabled() && !pool.isFaulty() && !pool.isDead();
+    }
+
+    Pool *PoolSwitcher::pickSplitPool(const SplitSchedule &schedule) {
+        //round-robin state of the calling thread. it belongs to the schedule it was made for, a thread that alternates
+        //between PoolSwitchers (or sees a new schedule after addPool) just starts over
+        thread_local const SplitSchedule *stateSchedule = nullptr;
+        thread_local std::vector<int64_t> currentWeights;
+        if (stateSchedule != &schedule || currentWeights.size() != schedule.pools.size()) {
+            stateSchedule = &schedule;
+            currentWeights.assign(schedule.pools.size(), 0);
+        }
+
+        int64_t totalWeight = 0;
+        size_t best = schedule.pools.size();
+
+        for (size_t i = 0; i < schedule.pools.size(); ++i) {
+            auto &entry = schedule.pools[i];
+            if (!isUsableForSplit(*entry.pool)) {
+                continue;
+            }
+            currentWeights[i] += entry.weight;
+            totalWeight += entry.weight;
+            if (best == schedule.pools.size() || currentWeights[i] > currentWeights[best]) {
+                best = i;
+            }
+        }
+
+        if (best == schedule.pools.size()) {
+            return nullptr;
+        }
+        currentWeights[best] -= totalWeight;
+        return schedule.pools[best].pool;
+    }
+
     unique_ptr<Work> PoolSwitcher::tryGetWorkImpl() {
-        //copy shared_ptr to active pool and access pool through copy
-        //because the active pool might change at any time
+        if (auto schedule = splitSchedule.get()) { //split mining
+            if (auto chosen = pickSplitPool(*schedule)) {
+                //solutions find their way back to the pool via their job, see submitSolutionImpl
+                if (auto work = chosen->tryGetWorkImpl()) {
+                    return work;
+                }
+                //the chosen pool has no work right now, rather hand out work of another weighted pool than none
+                for (auto &entry : schedule->pools) {
+                    if (entry.pool != chosen && isUsableForSplit(*entry.pool)) {
+                        if (auto work = entry.pool->tryGetWorkImpl()) {
+                            return work;
+                        }
+                    }
+                }
+                return nullptr;
+            }
+            //none of the weighted pools is usable, fall back to the active (backup) pool
+        }
+
+        //load the active pool once and access it through the local pointer
+        //because the active pool might change at any time (wait-free, see PublishedPtr)
         if (auto pool = active_pool.get()) {
             return pool->tryGetWorkImpl(); //thread-safe method
         }
 
         VLOG(2) << "PoolSwitcher cannot provide work since there is no active pool";
         //wait for event to prevent busy waiting in the algorithms' loops
-        std::unique_lock<std::mutex> lock(mut);
+        std::unique_lock<std::mutex> lock(*onStateChangeMutex);
         onStateChange->wait(lock, [this] () {
             return shutdown || active_pool.get();
         });
@@ -207,6 +412,7 @@ namespace riner {
     }
 
     void PoolSwitcher::submitSolutionImpl(unique_ptr<WorkSolution> solution) {
+        RNR_EXPECTS(solution->powTypeId == getPowTypeId());
         std::shared_ptr<const PoolJob> job = solution->tryGetJob(); //thread-safe method
         if (!job) {
             LOG(INFO) << "work solution is not submitted because its job is stale";
@@ -229,7 +435,7 @@ namespace riner {
             }
 
             sameUid = activePoolUid == solutionPoolUid;
-            if (!sameUid) {
+            if (!sameUid && !splitMining) {
                 LOG(INFO) << "solution will be submitted to non-active pool (uid " << solutionPoolUid << ") and not to current pool (uid " << activePoolUid << ")";
             }
             pool->submitSolutionImpl(std::move(solution)); //thread-safe method
@@ -6,7 +6,9 @@
 #include <list>
 #include <src/config/Config.h>
 #include <src/application/Registry.h>
+#include <src/util/PublishedPtr.h>
 #include <atomic>
+#include <limits>
 
 namespace riner {
 
@@ -16,7 +18,11 @@ namespace riner {
      * have a dead connection.
      * A connection is considered dead if the Pool (which extends StillAliveTrackable)
      * did not call its `onStillAlive()` for `PoolSwitcher::durUntilDeclaredDead` seconds
-     * This condition is being checked regularly on a separate thread every 'checkInterval' seconds by this class
+     * This condition is being checked regularly on a separate thread every 'checkInterval' seconds by this class,
+     * and exactly when the active pool would be declared dead.
+     * Besides that, the thread is woken up by events of the pools (disconnect, disabled, faults reported via
+     * `Pool::reportFault` such as repeated submit timeouts or rtt outliers), so that failover happens right away.
+     * Optionally the lowest latency pool is preferred over config order, see `setLatencyAwareSelection`.
      */
     class PoolSwitcher : public Pool {
     public:
@@ -37,17 +43,79 @@ namespace riner {
         /**
          * Tries to construct a pool (may fail if the poolImplName doesn't exist in `Registry`)
          * the new pool's `PoolRecords` will get connected to the total records of this PoolSwitcher
+         * @param splitWeight see addPool
          */
-        std::shared_ptr<Pool> tryAddPool(const PoolConstructionArgs &args, const char *poolImplName, const Registry &registry = Registry{}) {
+        std::shared_ptr<Pool> tryAddPool(const PoolConstructionArgs &args, const char *poolImplName, const Registry &registry = Registry{}, uint32_t splitWeight = 0) {
             std::shared_ptr<Pool> pool = registry.makePool(poolImplName, args);
             RNR_EXPECTS(pool != nullptr);
 
+            addPool(pool, splitWeight);
+            return pool;
+        }
+
+        /**
+         * adds an already constructed pool (with Pool::postInit already called), see tryAddPool
+         * the pool's PowType must match this PoolSwitcher's PowType
+         * @param splitWeight if > 0, the PoolSwitcher goes into split mining mode: tryGetWork draws work from all usable
+         * pools with splitWeight > 0 proportionally to their weights (smooth weighted round-robin per work item).
+         * Pools with splitWeight 0 are only used if none of the weighted pools is usable.
+         */
+        void addPool(std::shared_ptr<Pool> pool, uint32_t splitWeight = 0) {
+            RNR_EXPECTS(pool != nullptr);
+            RNR_EXPECTS(pool->getPowTypeId() == getPowTypeId());
+
             pool->addRecordsListener(records);
-            pool->setOnStateChangeCv(onStateChange);
-            _pools.lock()->emplace_back(pool);
+            pool->setOnStateChangeCv(onStateChange, onStateChangeMutex);
+            if (splitWeight > 0) {
+                std::lock_guard<std::mutex> lock(splitMutex);
+                auto schedule = std::make_shared<SplitSchedule>();
+                if (auto previous = splitSchedule.get()) {
+                    *schedule = *previous;
+                }
+                schedule->pools.push_back({pool.get(), splitWeight});
+                splitSchedule.set(std::move(schedule));
+                splitMining = true;
+            }
+            _pools.lock()->emplace_back(std::move(pool));
             notifyOnPoolsChange();
+        }
 
-            return pool;
+        /**
+         * @return the splitWeight the pool was added with (0 if it is not used for split mining)
+         */
+        uint32_t getSplitWeight(const Pool &pool) const;
+
+        /**
+         * @brief limits the amount of backup pools that stay connected (hot standby)
+         * The active pool and the `count` highest priority usable backup pools below it stay logged in and keep a
+         * current job in their WorkQueue, so that a failover can hand out work immediately. All pools with lower
+         * priority are deactivated (see Pool::setActive) and get activated again as soon as a standby pool fails.
+         * Pools with higher priority than the active pool always stay active, so they can take over again.
+         * By default all pools stay connected.
+         * @param count amount of standby pools
+         */
+        void setStandbyPoolCount(size_t count) {
+            standbyPoolCount = count;
+            notifyOnPoolsChange();
+        }
+
+        /**
+         * if enabled, the active pool is no longer the first usable pool in config order, but the usable pool with the
+         * lowest latency score (see latencyScoreSecs), so that fewer shares go stale.
+         * Pools without round trip measurements yet are ranked after the measured ones, in config order.
+         * To prevent flapping between similar pools, the active pool is only replaced by a pool that is clearly faster.
+         */
+        void setLatencyAwareSelection(bool enabled) {
+            latencyAwareSelection = enabled;
+            notifyOnPoolsChange();
+        }
+
+        /**
+         * @return the active pool (the one tryGetWork falls back to while split mining), or nullptr if there is none.
+         * the pointer is valid as long as the PoolSwitcher exists (see PublishedPtr)
+         */
+        const Pool *getActivePool() const {
+            return active_pool.get();
         }
 
         /**
@@ -94,8 +162,6 @@ namespace riner {
         //shutdown related variables
         std::atomic_bool shutdown {false};
 
-        mutable std::mutex mut;
-
         //periodic checking
         void periodicAliveCheck();
         std::future<void> periodicAliveCheckTask;
@@ -106,27 +172,70 @@ namespace riner {
         SharedLockGuarded<std::vector<shared_ptr<Pool>>> _pools;
         std::atomic<bool> pools_changed{false};
 
+        //split mining state, see addPool
+        struct SplitEntry {
+            Pool *pool; //owned by _pools
+            uint32_t weight;
+        };
+        struct SplitSchedule {
+            std::vector<SplitEntry> pools;
+        };
+        std::mutex splitMutex; //serializes addPool's updates of splitSchedule, readers don't lock
+        PublishedPtr<const SplitSchedule> splitSchedule; //replaced whenever a weighted pool is added, read on every tryGetWork
+        std::atomic_bool splitMining {false};
+
+        /**
+         * picks the next usable weighted pool via smooth weighted round-robin
+         * (every pick adds each usable pool's weight to its currentWeight, the pool with the highest currentWeight
+         * is chosen and its currentWeight is reduced by the sum of all usable weights), which interleaves the pools
+         * evenly, e.g. weights 7 and 3 result in AABAABAABA...
+         * The currentWeights are kept per calling thread, so that algorithm threads don't contend on them.
+         * @return nullptr if no weighted pool is usable
+         */
+        static Pool *pickSplitPool(const SplitSchedule &schedule);
+
+        /**
+         * @return whether split mining may draw work from pool right now
+         */
+        static bool isUsableForSplit(const Pool &pool);
+
+        std::atomic_bool latencyAwareSelection {false};
+
+        /**
+         * latency score of a pool in seconds: its smoothed round trip time plus how much later than the other pools
+         * it sends new blocks on average (see averageJobLagSecs), scaled up by the fraction of rejected shares
+         * (a pool that rejects half of the shares is treated as if it was twice as slow)
+         * @return nullopt if the pool has no round trip measurements yet
+         */
+        optional<double> latencyScoreSecs(const Pool &pool, double jobLagSecs) const;
+
+        /**
+         * matches the recent clean job arrival times of pool `index` with those of the other pools (arrivals within a few
+         * seconds of each other are assumed to be the same block) and averages how much later than the earliest pool
+         * it received them
+         * @param jobTimes recent clean job times of all pools, see Pool::getRecentCleanJobTimes
+         * @return average lag in seconds, 0 if no job could be matched
+         */
+        static double averageJobLagSecs(size_t index, const std::vector<std::vector<clock::time_point>> &jobTimes);
+
+        std::atomic<size_t> standbyPoolCount {std::numeric_limits<size_t>::max()};
+        std::atomic<size_t> usableStandbyPools {0}; //as counted by the latest aliveCheckAndMaybeSwitch call
+
+        /**
+         * @return amount of connected, non-faulty, activated pools other than the active pool
+         */
+        size_t countUsableStandbyPools() const;
+
         /**
          * after changes of _pools this method shall be called, so that the PoolSwitcher can check pools immediately
          */
         inline void notifyOnPoolsChange() {
             pools_changed = true;
-            onStateChange->notify_all();
+            notifyStateChange();
         }
 
-        struct {
-        private:
-            std::shared_ptr<Pool> pool;
-
-        public:
-            inline std::shared_ptr<Pool> get() const {
-                return std::atomic_load(&pool);
-            }
-
-            inline void set(std::shared_ptr<Pool> new_pool) {
-                std::atomic_store(&pool, new_pool);
-            }
-        } active_pool;
+        //read by every algorithm thread on each tryGetWork, see PublishedPtr for why get() can return a raw pointer
+        PublishedPtr<Pool> active_pool;
 
         /**
          * check which pools are still alive and if the active pool is no longer alive, switch active pool.
@@ -0,0 +1,385 @@
+
+#include <src/pool/PoolSwitcher.h>
+#include <src/pool/WorkQueue.h>
+#include <src/pool/WorkDummy.h>
+#include <src/util/Logging.h>
+
+#include <gtest/gtest.h>
+
+namespace riner {
+namespace {
+
+using namespace std::chrono;
+
+struct StandInJob : public PoolJob {
+    explicit StandInJob(const std::weak_ptr<Pool> &pool) : PoolJob(pool) {
+    }
+
+    unique_ptr<Work> makeWork() override {
+        return std::make_unique<WorkDummy>();
+    }
+};
+
+/**
+ * Pool whose server side is simulated in-process, so that the tests can trigger
+ * server events (jobs, dropped connections, late responses) deterministically
+ */
+class StandInPool : public Pool {
+    WorkQueue queue {2, 4};
+
+public:
+    using Pool::maxConsecutiveStrikes;
+    std::atomic<int> reconnects {0};
+    std::atomic_bool outOfWork {false}; //if set, the queue behaves as if it was empty
+
+    explicit StandInPool(std::string host)
+            : Pool(PoolConstructionArgs{std::move(host), 0, "", "", SslDesc{}}) {
+    }
+
+    void serverSendsJob() {
+        onStillAlive();
+        setConnected(true);
+        queue.pushJob(std::make_unique<StandInJob>(_this), true);
+    }
+
+    void serverSendsNewBlock() {
+        reportJobArrived(true);
+        serverSendsJob();
+    }
+
+    void serverDropsConnection() {
+        setConnected(false);
+    }
+
+    void serverMissesSubmitResponses() {
+        for (uint32_t i = 0; i < maxConsecutiveStrikes; ++i) {
+            reportTimeout("share submission timed out");
+        }
+    }
+
+    void serverRespondsLateToSubmit(clock::duration rtt) {
+        reportTimeout("share submission timed out");
+        serverRespondsAfter(rtt);
+    }
+
+    void serverRespondsAfter(clock::duration rtt) {
+        onStillAlive();
+        reportRoundTrip(rtt);
+    }
+
+    void expireJobs() override {
+        queue.expireJobs();
+    }
+
+    void clearJobs() override {
+        queue.clear();
+    }
+
+    bool isExpiredJob(const PoolJob &job) override {
+        return queue.isExpiredJob(job);
+    }
+
+    void onDeclaredDead() override {
+        ++reconnects;
+        setConnected(false);
+    }
+
+    unique_ptr<Work> tryGetWorkImpl() override {
+        if (outOfWork) {
+            std::this_thread::sleep_for(milliseconds(20)); //pop timeout
+            return nullptr;
+        }
+        return queue.popWithTimeout(milliseconds(20));
+    }
+
+    void submitSolutionImpl(unique_ptr<WorkSolution>) override {
+        records.reportShare(1, true, false);
+    }
+};
+
+class PoolSwitcherFailover : public ::testing::Test {
+protected:
+    //periodic checks are disabled for all practical purposes, so every switch must be event driven
+    PoolSwitcher switcher {HasPowTypeDummy::getPowType(), hours(1), hours(1)};
+    std::shared_ptr<StandInPool> primary = makePool("primary");
+    std::shared_ptr<StandInPool> backup = makePool("backup");
+
+    std::shared_ptr<StandInPool> makePool(std::string name) {
+        auto pool = std::make_shared<StandInPool>(std::move(name));
+        Pool::postInit(pool, "StandInPool", HasPowTypeDummy::getPowType());
+        switcher.addPool(pool);
+        return pool;
+    }
+
+    /**
+     * @return time until the switcher handed out work from pool, or nullopt if that didn't happen within timeout
+     */
+    optional<steady_clock::duration> timeUntilWorkFrom(const std::shared_ptr<StandInPool> &pool, steady_clock::duration timeout = seconds(10)) {
+        auto start = steady_clock::now();
+        while (steady_clock::now() - start < timeout) {
+            auto work = switcher.tryGetWork<WorkDummy>();
+            if (work) {
+                auto job = work->tryGetJob();
+                if (job && job->pool.lock() == pool) {
+                    return steady_clock::now() - start;
+                }
+            }
+        }
+        return nullopt;
+    }
+
+    void SetUp() override {
+        primary->serverSendsJob();
+        ASSERT_TRUE(timeUntilWorkFrom(primary));
+        backup->serverSendsJob();
+    }
+
+    void TearDown() override {
+        //the pools' records refer to the switcher's records, let the switcher own the pools' last references
+        primary.reset();
+        backup.reset();
+    }
+
+    template<class Pred>
+    static bool waitUntil(Pred &&pred) {
+        for (int i = 0; i < 100 && !pred(); ++i) {
+            std::this_thread::sleep_for(milliseconds(10));
+        }
+        return pred();
+    }
+
+    static bool waitForReconnect(const std::shared_ptr<StandInPool> &pool) {
+        return waitUntil([&] {return pool->reconnects > 0;});
+    }
+
+    static void logLatency(const char *event, steady_clock::duration latency) {
+        LOG(INFO) << "failover after " << event << " took " << duration<double, std::milli>(latency).count() << "ms";
+    }
+};
+
+TEST_F(PoolSwitcherFailover, SwitchesOnDisconnect) {
+    auto oldWork = switcher.tryGetWork<WorkDummy>();
+    ASSERT_NE(oldWork, nullptr);
+
+    primary->serverDropsConnection();
+    auto latency = timeUntilWorkFrom(backup);
+    ASSERT_TRUE(latency);
+    EXPECT_LT(*latency, seconds(1));
+    logLatency("disconnect", *latency);
+
+    EXPECT_TRUE(oldWork->expired());
+}
+
+TEST_F(PoolSwitcherFailover, SwitchesAndReconnectsOnSubmitTimeout) {
+    primary->serverMissesSubmitResponses();
+    auto latency = timeUntilWorkFrom(backup);
+    ASSERT_TRUE(latency);
+    EXPECT_LT(*latency, seconds(1));
+    logLatency("submit timeout", *latency);
+
+    EXPECT_TRUE(waitForReconnect(primary));
+}
+
+TEST_F(PoolSwitcherFailover, SwitchesOnRoundTripOutlier) {
+    for (int i = 0; i < 10; ++i) {
+        primary->serverRespondsAfter(milliseconds(50));
+    }
+    EXPECT_FALSE(primary->isFaulty());
+
+    //a single outlier is tolerated, several in a row are not
+    primary->serverRespondsAfter(seconds(5));
+    EXPECT_FALSE(primary->isFaulty());
+    for (uint32_t i = 1; i < StandInPool::maxConsecutiveStrikes; ++i) {
+        primary->serverRespondsAfter(seconds(5));
+    }
+    EXPECT_TRUE(primary->isFaulty());
+
+    auto latency = timeUntilWorkFrom(backup);
+    ASSERT_TRUE(latency);
+    EXPECT_LT(*latency, seconds(1));
+    logLatency("rtt outlier", *latency);
+}
+
+TEST_F(PoolSwitcherFailover, SingleSlowSubmitResponseDoesNotSwitch) {
+    for (int i = 0; i < 10; ++i) {
+        primary->serverRespondsAfter(milliseconds(50));
+    }
+
+    //the submit times out once and its response arrives late (which is also an rtt outlier), then all is normal again
+    primary->serverRespondsLateToSubmit(milliseconds(5500));
+    primary->serverRespondsAfter(milliseconds(50));
+    primary->serverRespondsLateToSubmit(milliseconds(5500));
+
+    EXPECT_FALSE(primary->isFaulty());
+    EXPECT_FALSE(timeUntilWorkFrom(backup, milliseconds(200)));
+    EXPECT_EQ(primary->reconnects, 0);
+}
+
+TEST_F(PoolSwitcherFailover, FaultIsClearedByReconnect) {
+    primary->serverMissesSubmitResponses();
+    ASSERT_TRUE(timeUntilWorkFrom(backup));
+    ASSERT_TRUE(waitForReconnect(primary));
+
+    primary->serverSendsJob();
+    EXPECT_FALSE(primary->isFaulty());
+}
+
+TEST_F(PoolSwitcherFailover, KeepsOnlyConfiguredStandbysConnected) {
+    auto third = makePool("third");
+    third->serverSendsJob();
+
+    switcher.setStandbyPoolCount(1);
+    EXPECT_TRUE(waitUntil([&] {return !third->isActive();}));
+    EXPECT_FALSE(third->isConnected());
+    EXPECT_TRUE(backup->isActive());
+    EXPECT_TRUE(backup->isConnected());
+
+    //the standby already has work, so the failover doesn't wait for connect, login and the first job
+    primary->serverDropsConnection();
+    auto latency = timeUntilWorkFrom(backup);
+    ASSERT_TRUE(latency);
+    EXPECT_LT(*latency, seconds(1));
+    logLatency("disconnect with hot standby", *latency);
+
+    //the failed primary keeps trying to reconnect, the next backup becomes the new standby
+    EXPECT_TRUE(waitUntil([&] {return third->isActive();}));
+    EXPECT_TRUE(primary->isActive());
+}
+
+using PoolSwitcherLatency = PoolSwitcherFailover;
+
+TEST_F(PoolSwitcherLatency, PrefersLowestRoundTrip) {
+    for (int i = 0; i < 4; ++i) {
+        primary->serverRespondsAfter(milliseconds(200));
+        backup->serverRespondsAfter(milliseconds(20));
+    }
+    //config order is kept unless latency aware selection is enabled
+    EXPECT_FALSE(timeUntilWorkFrom(backup, milliseconds(100)));
+
+    switcher.setLatencyAwareSelection(true);
+    EXPECT_TRUE(timeUntilWorkFrom(backup));
+}
+
+TEST_F(PoolSwitcherLatency, PrefersPoolThatSendsBlocksFirst) {
+    for (int i = 0; i < 4; ++i) {
+        primary->serverRespondsAfter(milliseconds(20));
+        backup->serverRespondsAfter(milliseconds(20));
+    }
+    backup->serverSendsNewBlock();
+    std::this_thread::sleep_for(milliseconds(200));
+    primary->serverSendsNewBlock();
+
+    switcher.setLatencyAwareSelection(true);
+    EXPECT_TRUE(timeUntilWorkFrom(backup));
+}
+
+TEST_F(PoolSwitcherLatency, KeepsActivePoolIfOthersAreOnlySlightlyFaster) {
+    for (int i = 0; i < 4; ++i) {
+        primary->serverRespondsAfter(milliseconds(110));
+        backup->serverRespondsAfter(milliseconds(100));
+    }
+    switcher.setLatencyAwareSelection(true);
+    EXPECT_FALSE(timeUntilWorkFrom(backup, milliseconds(200)));
+}
+
+class PoolSwitcherSplit : public ::testing::Test {
+protected:
+    PoolSwitcher switcher {HasPowTypeDummy::getPowType(), hours(1), hours(1)};
+    std::shared_ptr<StandInPool> a = makePool("a", 7);
+    std::shared_ptr<StandInPool> b = makePool("b", 3);
+
+    std::shared_ptr<StandInPool> makePool(std::string name, uint32_t splitWeight) {
+        auto pool = std::make_shared<StandInPool>(std::move(name));
+        Pool::postInit(pool, "StandInPool", HasPowTypeDummy::getPowType());
+        switcher.addPool(pool, splitWeight);
+        pool->serverSendsJob();
+        return pool;
+    }
+
+    void SetUp() override {
+        //pools start out dead until the switcher's alive-check has seen them
+        for (int i = 0; i < 100 && (a->isDead() || b->isDead()); ++i) {
+            std::this_thread::sleep_for(milliseconds(10));
+        }
+        ASSERT_FALSE(a->isDead() || b->isDead());
+    }
+
+    void TearDown() override {
+        a.reset();
+        b.reset();
+    }
+};
+
+TEST_F(PoolSwitcherSplit, SplitsWorkAndSolutionsByWeight) {
+    EXPECT_EQ(switcher.getSplitWeight(*a), 7);
+    EXPECT_EQ(switcher.getSplitWeight(*b), 3);
+
+    int fromA = 0, fromB = 0;
+    for (int i = 0; i < 100; ++i) {
+        auto work = switcher.tryGetWork<WorkDummy>();
+        ASSERT_NE(work, nullptr);
+        auto job = work->tryGetJob();
+        ASSERT_NE(job, nullptr);
+        auto pool = job->pool.lock();
+        fromA += pool == a;
+        fromB += pool == b;
+
+        //the solution must be routed to the pool its work came from
+        switcher.submitSolution(work->makeWorkSolution<WorkSolutionDummy>());
+    }
+    EXPECT_EQ(fromA, 70);
+    EXPECT_EQ(fromB, 30);
+
+    auto total = switcher.readRecords();
+    EXPECT_NEAR(a->readRecords().effectiveShareOf(total), 0.7, 1e-9);
+    EXPECT_NEAR(b->readRecords().effectiveShareOf(total), 0.3, 1e-9);
+}
+
+TEST_F(PoolSwitcherSplit, ActivePoolChangeKeepsWorkOfOtherWeightedPool) {
+    unique_ptr<WorkDummy> workOfA;
+    for (int i = 0; i < 10 && !workOfA; ++i) {
+        auto work = switcher.tryGetWork<WorkDummy>();
+        ASSERT_NE(work, nullptr);
+        if (work->tryGetJob()->pool.lock() == a) {
+            workOfA = std::move(work);
+        }
+    }
+    ASSERT_NE(workOfA, nullptr);
+    ASSERT_EQ(switcher.getActivePool(), a.get());
+
+    //make b the active pool while both stay usable
+    for (int i = 0; i < 4; ++i) {
+        a->serverRespondsAfter(milliseconds(200));
+        b->serverRespondsAfter(milliseconds(20));
+    }
+    switcher.setLatencyAwareSelection(true);
+    for (int i = 0; i < 100 && switcher.getActivePool() != b.get(); ++i) {
+        std::this_thread::sleep_for(milliseconds(10));
+    }
+    ASSERT_EQ(switcher.getActivePool(), b.get());
+    EXPECT_FALSE(a->isFaulty());
+
+    //a is still drawn from by the split, so its queued jobs must not have been expired
+    EXPECT_FALSE(workOfA->expired());
+}
+
+TEST_F(PoolSwitcherSplit, SkipsUnusablePools) {
+    b->serverDropsConnection();
+    for (int i = 0; i < 10; ++i) {
+        auto work = switcher.tryGetWork<WorkDummy>();
+        ASSERT_NE(work, nullptr);
+        EXPECT_EQ(work->tryGetJob()->pool.lock(), a);
+    }
+}
+
+TEST_F(PoolSwitcherSplit, FallsBackToWeightedPoolWithWork) {
+    a->outOfWork = true;
+    for (int i = 0; i < 10; ++i) {
+        auto work = switcher.tryGetWork<WorkDummy>();
+        ASSERT_NE(work, nullptr);
+        EXPECT_EQ(work->tryGetJob()->pool.lock(), b);
+    }
+}
+
+} // namespace
+} // riner
@@ -0,0 +1,49 @@
+//
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace riner {
+
+    /**
+     * integer id of a PowType string (e.g. "ethash"), so that Work/WorkSolution/Pool compatibility checks
+     * are integer compares instead of string compares.
+     * the id is a 32 bit FNV-1a hash of the lowercase PowType string. PowType names are case insensitive
+     * elsewhere (e.g. in the Registry), so two names that only differ in case share an id.
+     * Collisions between registered PowTypes are checked by the Registry.
+     */
+    using PowTypeId = uint32_t;
+
+    constexpr PowTypeId powTypeIdFromString(const char *powType) {
+        uint32_t hash = 2166136261u;
+        for (; *powType; ++powType) {
+            char c = *powType;
+            if (c >= 'A' && c <= 'Z') {
+                c = static_cast<char>(c - 'A' + 'a');
+            }
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    inline PowTypeId powTypeIdFromString(const std::string &powType) {
+        return powTypeIdFromString(powType.c_str());
+    }
+
+    /**
+     * compile time PowTypeId of a class with a static `getPowType()` method (e.g. HasPowTypeEthash, WorkEthash, ...)
+     * usage: `PowTypeIdOf<WorkEthash>::value`
+     */
+    template<class T>
+    struct PowTypeIdOf {
+        static constexpr PowTypeId value = powTypeIdFromString(T::getPowType());
+    };
+
+    template<class T>
+    constexpr PowTypeId PowTypeIdOf<T>::value;
+
+}
@@ -0,0 +1,173 @@
+//
+//
+
+#include "ReplayPoolServer.h"
+#include <src/util/Logging.h>
+
+namespace riner {
+
+    namespace {
+
+        //parses a jrpc line leniently, returns a discarded json value if it isn't a json object
+        nl::json parseObject(const std::string &line) {
+            auto j = nl::json::parse(line, nullptr, false);
+            if (!j.is_object())
+                return nl::json::value_t::discarded;
+            return j;
+        }
+
+        bool isResponse(const nl::json &j) {
+            return j.is_object() && j.count("id") && !j.at("id").is_null() && !j.count("method");
+        }
+
+        nl::json idOf(const nl::json &j) {
+            if (j.is_object() && j.count("id"))
+                return j.at("id");
+            return nullptr;
+        }
+
+    }
+
+    ReplayPoolServer::ReplayPoolServer(uint16_t port, const std::string &recordingPath, double speed)
+            : ReplayPoolServer(port, SessionRecorder::load(recordingPath), speed) {
+    }
+
+    ReplayPoolServer::ReplayPoolServer(uint16_t port, std::vector<SessionRecord> records, double speed)
+            : _speed(speed) {
+        RNR_EXPECTS(speed >= 0);
+        prepare(records);
+
+        //this class pretends to be an external pool server, so we don't want it to show up in the logs => set verbosity to 9
+        io.setLoggingVerbosity(9);
+
+        io.setOnReceive([this] (CxnHandle cxn, std::string line) {
+            if (_session) {
+                onClientLine(line);
+                io.readAsync(cxn);
+            }
+        });
+
+        auto onCxn = [this] (CxnHandle cxn) {
+            if (_session) return;
+
+            _session = Session{cxn};
+            _session->lastSent = clock::now();
+            _sentLines = 0;
+            ++_sessionCount;
+
+            io.readAsync(cxn);
+            sendDue();
+        };
+
+        auto onDc = [this] {
+            //also called for connections that were ignored because a session was running
+            if (_session && _session->cxn.closed())
+                _session = nullopt;
+        };
+
+        io.launchServer(port, onCxn, onDc);
+    }
+
+    size_t ReplayPoolServer::sentLines() const {
+        return _sentLines;
+    }
+
+    void ReplayPoolServer::prepare(const std::vector<SessionRecord> &records) {
+        std::vector<nl::json> clientIds; //ids of the outbound records
+        clock::duration previousOffset {};
+        bool previousIsClientLine = false;
+
+        for (auto &record : records) {
+            auto gap = record.offset - previousOffset;
+            previousOffset = record.offset;
+
+            if (record.direction == SessionRecord::outbound) {
+                clientIds.push_back(idOf(parseObject(record.line)));
+                previousIsClientLine = true;
+                continue;
+            }
+
+            Inbound inbound {record.line, gap, clientIds.size(), previousIsClientLine, nullopt, nullptr};
+            previousIsClientLine = false;
+
+            auto j = parseObject(record.line);
+            if (isResponse(j)) {
+                //the request this is a response to is the latest client line with that id
+                for (size_t i = clientIds.size(); i-- > 0;) {
+                    if (clientIds[i] == j.at("id")) {
+                        inbound.respondsTo = i;
+                        inbound.recordedId = j.at("id");
+                        break;
+                    }
+                }
+            }
+            _inbound.push_back(std::move(inbound));
+        }
+
+        VLOG(1) << "replay pool server: " << _inbound.size() << " pool lines and " << clientIds.size()
+                << " client lines in recording";
+    }
+
+    void ReplayPoolServer::onClientLine(const std::string &line) {
+        _session->clientIds.push_back(idOf(parseObject(line)));
+        _session->clientTimes.push_back(clock::now());
+        sendDue();
+    }
+
+    optional<clock::time_point> ReplayPoolServer::dueTime(const Inbound &inbound) const {
+        auto &s = *_session;
+        if (s.clientIds.size() < inbound.clientLinesBefore)
+            return nullopt; //the client didn't get this far yet
+
+        auto anchor = inbound.followsClientLine ? s.clientTimes[inbound.clientLinesBefore - 1] : s.lastSent;
+        if (_speed == 0)
+            return anchor;
+        return anchor + std::chrono::duration_cast<clock::duration>(inbound.gap / _speed);
+    }
+
+    void ReplayPoolServer::sendDue() {
+        auto &s = *_session;
+        auto now = clock::now();
+        std::vector<std::string> lines;
+
+        for (; s.next < _inbound.size(); ++s.next) {
+            auto &inbound = _inbound[s.next];
+            auto due = dueTime(inbound);
+            if (!due || *due > now)
+                break;
+
+            std::string line = inbound.line;
+            if (inbound.respondsTo) {
+                const auto &id = s.clientIds[*inbound.respondsTo];
+                if (!id.is_null() && id != inbound.recordedId) {
+                    auto j = nl::json::parse(line);
+                    j["id"] = id;
+                    line = j.dump();
+                }
+            }
+            lines.push_back(line + '\n');
+            s.lastSent = *due; //not 'now', so that lateness of the timer doesn't add up over the session
+        }
+
+        if (!lines.empty()) {
+            _sentLines += lines.size();
+            io.writeAsync(s.cxn, std::move(lines));
+        }
+
+        if (s.next == _inbound.size())
+            return; //session is over
+
+        //arm the timer for the next line, unless it is already armed early enough (or the line waits for the client)
+        auto due = dueTime(_inbound[s.next]);
+        if (!due || (s.timerDue && *s.timerDue <= *due))
+            return;
+        s.timerDue = due;
+        io.postAsyncAt(*due, [this, sessionCount = _sessionCount, due = *due] () {
+            if (!_session || _sessionCount != sessionCount || _session->timerDue != due)
+                return; //session is over or the timer was re-armed for an earlier line
+            _session->timerDue = nullopt;
+            sendDue();
+        });
+    }
+
+}
@@ -0,0 +1,84 @@
+//
+//
+
+#pragma once
+
+#include <src/network/LineIO.h>
+#include <src/network/SessionRecorder.h>
+#include <src/common/Optional.h>
+#include <src/common/Json.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace riner {
+
+    /**
+     * serves a session that was recorded with a `SessionRecorder` on a pool connection back to a connecting miner,
+     * so that real pool sessions can be reproduced offline and job handling of e.g. PoolEthashStratum or
+     * PoolGrinStratum can be benchmarked without a live pool.
+     *
+     * the recorded inbound lines (what the pool sent) are sent in their recorded order. each line is held back until the
+     * client has sent as many lines as had been sent before it in the recording, and is then sent at its recorded
+     * distance to the previous line, divided by `speed`. ids of responses are replaced with the id of the client line
+     * that corresponds to the recorded request, since the client's ids usually differ between runs.
+     *
+     * like `DummyTestPoolServer`, only one connection is served at a time. every new connection replays the session
+     * from the start. lines that the client sends beyond the recording are ignored.
+     */
+    class ReplayPoolServer {
+    public:
+        /**
+         * @param port port to listen on (localhost)
+         * @param records recorded session, see `SessionRecorder::load()`
+         * @param speed 1 replays at the recorded pace, 2 twice as fast etc., 0 sends every line as soon as the client allows
+         */
+        ReplayPoolServer(uint16_t port, std::vector<SessionRecord> records, double speed = 1);
+
+        ReplayPoolServer(uint16_t port, const std::string &recordingPath, double speed = 1);
+
+        /**
+         * @return number of recorded inbound lines that were sent in the current (or last) session.
+         * only for statistics/tests, only reliable once the client stopped sending
+         */
+        size_t sentLines() const;
+
+    private:
+        struct Inbound {
+            std::string line;
+            clock::duration gap; //recorded time since the previous record
+            size_t clientLinesBefore; //outbound records that precede this one
+            bool followsClientLine; //whether the previous record is an outbound one
+            optional<size_t> respondsTo; //index of the outbound record whose id this response carries
+            nl::json recordedId; //id of the response as recorded, if respondsTo is set
+        };
+
+        struct Session {
+            CxnHandle cxn;
+            size_t next = 0; //index into _inbound
+            clock::time_point lastSent; //actual time the previous inbound line was sent
+            std::vector<nl::json> clientIds; //ids of the client's lines in order (null if none)
+            std::vector<clock::time_point> clientTimes; //arrival times of the client's lines
+            optional<clock::time_point> timerDue; //time the send timer is armed for, if it is armed
+        };
+
+        void prepare(const std::vector<SessionRecord> &records);
+
+        void onClientLine(const std::string &line);
+
+        //time at which the inbound line can be sent, nullopt if it waits for the client
+        optional<clock::time_point> dueTime(const Inbound &) const;
+
+        //sends every inbound line that is due and arms the send timer for the next one
+        void sendDue();
+
+        std::vector<Inbound> _inbound;
+        double _speed;
+        optional<Session> _session; //only accessed on the io thread
+        uint64_t _sessionCount = 0; //lets the send timer of a previous session notice that it is outdated
+        std::atomic_size_t _sentLines {0};
+
+        LineIO io{"replay pool server |"};
+    };
+
+}
@@ -0,0 +1,158 @@
+
+#include <src/pool/ReplayPoolServer.h>
+#include <src/network/SessionRecorder.h>
+#include <src/network/JsonRpcBuilder.h>
+#include <src/network/JsonRpcUtil.h>
+#include <src/util/Barrier.h>
+
+#include <gtest/gtest.h>
+#include <atomic>
+
+namespace riner {
+    using namespace jrpc;
+    using namespace std::chrono_literals;
+    using RB = RequestBuilder;
+
+    namespace {
+
+        //logs in like a stratum client, calls `done` once `notifies` mining.notify notifications arrived
+        void runStratumClient(JsonRpcUtil &client, uint16_t port, int firstId, std::vector<nl::json> &responseIds,
+                              size_t notifies, Barrier &done) {
+            auto notified = std::make_shared<std::atomic_size_t>(0);
+            client.addMethod("mining.notify", [&, notified, notifies] (nl::json params) {
+                if (++*notified == notifies)
+                    done.unblock();
+            });
+
+            client.launchClient("127.0.0.1", port, [&, firstId] (CxnHandle cxn) {
+                client.setReadAsyncLoopEnabled(true);
+                client.readAsync(cxn);
+                client.callAsync(cxn, RB{}.id(firstId).method("mining.subscribe").done(), [&] (CxnHandle cxn, Message res) {
+                    responseIds.push_back(res.id);
+                    client.callAsync(cxn, RB{}.id(firstId + 1).method("mining.authorize").param("user").done(), [&] (CxnHandle, Message res) {
+                        responseIds.push_back(res.id);
+                    });
+                });
+            });
+        }
+
+    }
+
+    TEST(ReplayPoolServer, ReplaysRecordedSession) {
+        const size_t notifies = 3;
+        std::string path = testing::TempDir() + "riner_replay_test_session.txt";
+
+        {//record a session with a stand-in pool
+            Barrier done;
+            std::vector<nl::json> responseIds;
+            SessionRecorder recorder{path};
+            ASSERT_TRUE(recorder.good());
+
+            JsonRpcUtil pool{"stand-in pool"};
+            optional<CxnHandle> poolCxn;
+            pool.addMethod("mining.subscribe", [] () {
+                return true;
+            });
+            pool.addMethod("mining.authorize", [&] () {
+                pool.io().retryAsyncEvery(10ms, [&, n = size_t(0)] () mutable {
+                    pool.callAsync(*poolCxn, RB{}.method("mining.notify").param("0x0" + std::to_string(n)).done());
+                    return ++n == notifies;
+                }, []{});
+                return true;
+            });
+            pool.launchServer(4050, [&] (CxnHandle cxn) {
+                poolCxn = cxn;
+                pool.setReadAsyncLoopEnabled(true);
+                pool.readAsync(cxn);
+            });
+
+            JsonRpcUtil client{"recording client"};
+            recorder.tap(client);
+            runStratumClient(client, 4050, 1, responseIds, notifies, done);
+            ASSERT_NE(done.wait_for(10s), std::future_status::timeout);
+            EXPECT_TRUE(recorder.good());
+        }
+
+        auto records = SessionRecorder::load(path);
+        ASSERT_EQ(records.size(), 2 + 2 + notifies); //2 requests, 2 responses, notifications
+        EXPECT_EQ(records[0].direction, SessionRecord::outbound);
+        EXPECT_EQ(records[1].direction, SessionRecord::inbound);
+        for (size_t i = 1; i < records.size(); ++i) {
+            EXPECT_LE(records[i - 1].offset, records[i].offset);
+        }
+        //the notifications were sent 10ms apart
+        EXPECT_GE(records.back().offset - records[records.size() - notifies].offset, (notifies - 1) * 10ms);
+
+        for (double speed : {0.0, 4.0}) {
+            ReplayPoolServer replay{4051, records, speed};
+
+            //a client with different ids must get responses with its own ids
+            Barrier done;
+            std::vector<nl::json> responseIds;
+            JsonRpcUtil client{"replay client"};
+            runStratumClient(client, 4051, 100, responseIds, notifies, done);
+            ASSERT_NE(done.wait_for(10s), std::future_status::timeout);
+
+            EXPECT_EQ(replay.sentLines(), 2 + notifies);
+            EXPECT_EQ(responseIds, (std::vector<nl::json>{100, 101}));
+        }
+    }
+
+    TEST(ReplayPoolServer, IgnoredConnectionDoesNotEndSession) {
+        //only one connection is served at a time, a second one that is ignored and closed must not end the session
+        std::vector<SessionRecord> records {
+            {SessionRecord::inbound, 0ms, RB{}.method("mining.notify").param("0x00").done().str()},
+            {SessionRecord::inbound, 200ms, RB{}.method("mining.notify").param("0x01").done().str()},
+        };
+        ReplayPoolServer replay{4052, records};
+
+        Barrier firstNotified;
+        Barrier done;
+        std::atomic_size_t notified {0};
+        JsonRpcUtil client{"replay client"};
+        client.addMethod("mining.notify", [&] (nl::json params) {
+            if (++notified == 1)
+                firstNotified.unblock();
+            else
+                done.unblock();
+        });
+        client.launchClient("127.0.0.1", 4052, [&] (CxnHandle cxn) {
+            client.setReadAsyncLoopEnabled(true);
+            client.readAsync(cxn);
+        });
+        ASSERT_NE(firstNotified.wait_for(10s), std::future_status::timeout);
+
+        Barrier ignored;
+        LineIO second;
+        second.launchClient("127.0.0.1", 4052, [&] (CxnHandle cxn) {
+            second.readAsync(cxn);
+        }, [&] () {
+            ignored.unblock(); //closed by the server
+        });
+        ASSERT_NE(ignored.wait_for(10s), std::future_status::timeout);
+
+        EXPECT_NE(done.wait_for(2s), std::future_status::timeout);
+        EXPECT_EQ(replay.sentLines(), 2u);
+    }
+
+    TEST(ReplayPoolServer, LoadSkipsMalformedLines) {
+        std::string path = testing::TempDir() + "riner_replay_test_malformed.txt";
+        {
+            std::ofstream file(path);
+            file << "# riner session recording v1\n"
+                 << "> 5 {\"id\":1,\"method\":\"a\"}\n"
+                 << "x 3 garbage\n"
+                 << "<7\n"
+                 << "\n"
+                 << "< 1000 {\"id\":1,\"result\":true}\n";
+        }
+
+        auto records = SessionRecorder::load(path);
+        ASSERT_EQ(records.size(), 2u);
+        EXPECT_EQ(records[0].direction, SessionRecord::outbound);
+        EXPECT_EQ(records[0].line, R"({"id":1,"method":"a"})");
+        EXPECT_EQ(records[1].direction, SessionRecord::inbound);
+        EXPECT_EQ(records[1].offset, std::chrono::microseconds(1005));
+    }
+
+}
@@ -21,11 +21,11 @@ namespace riner {
     }
 
     WorkSolution::WorkSolution(const Work &work)
-            : job(work.job), powType(work.powType) {
+            : job(work.job), expiryToken(work.expiryToken), jobId(work.jobId), powTypeId(work.powTypeId) {
     }
 
-    Work::Work(const std::string &powType)
-            : powType(powType) {
+    Work::Work(PowTypeId powTypeId)
+            : powTypeId(powTypeId) {
     }
 
 }
\ No newline at end of file
@@ -3,8 +3,12 @@
 
 #include <src/common/Pointers.h>
 #include <src/common/Optional.h>
+#include <src/pool/ExpiryToken.h>
+#include <src/pool/PowType.h>
 #include <atomic>
+#include <chrono>
 #include <string>
+#include <thread>
 
 namespace riner {
 
@@ -32,6 +36,9 @@ namespace riner {
          *
          * If used by a WorkQueue, makeWork is always called sequentially while a lock is held (so no concurrent invocations of makeWork() on the same PoolJob can exist).
          *
+         * Work subclasses that inherit from Recyclable<T> (see RecyclingPool.h) are allocated from a per-type free list,
+         * so a plain make_unique<T>() in here does not hit the heap for every work item.
+         *
          * @return: a unique_ptr to a subclass of Work that was created by this function, based on this PoolJob
          */
         virtual unique_ptr<Work> makeWork() = 0;
@@ -48,6 +55,8 @@ namespace riner {
      */
     class WorkSolution {
         std::weak_ptr<const PoolJob> job;
+        std::shared_ptr<const ExpiryToken> expiryToken; //may be nullptr if the work did not come from a queue
+        int64_t jobId = 0;
 
     protected:
         explicit WorkSolution(const Work &work);
@@ -69,7 +78,7 @@ namespace riner {
             return job.lock();
         }
 
-        const std::string powType;
+        const PowTypeId powTypeId; //copied from the Work this solution was made from
 
         virtual ~WorkSolution() = default;
 
@@ -79,7 +88,7 @@ namespace riner {
         template<class T>
         T *downCast() {
             static_assert(std::is_base_of<WorkSolution, T>::value, "");
-            return T::getPowType() == powType ? static_cast<T*>(this) : nullptr;
+            return PowTypeIdOf<T>::value == powTypeId ? static_cast<T*>(this) : nullptr;
         }
 
         /**
@@ -88,7 +97,7 @@ namespace riner {
         template<class T>
         const T *downCast() const {
             static_assert(std::is_base_of<WorkSolution, T>::value, "");
-            return T::getPowType() == powType ? static_cast<const T*>(this) : nullptr;
+            return PowTypeIdOf<T>::value == powTypeId ? static_cast<const T*>(this) : nullptr;
         }
 
         /**
@@ -98,6 +107,9 @@ namespace riner {
          * @return whether the solution has been marked expired by the pool protocol implementation
          */
         bool expired() const { //thread safe
+            if (expiryToken) {
+                return expiryToken->isExpired(jobId);
+            }
             bool expired = true;
             if (auto sharedPtr = job.lock())
                 expired = sharedPtr->expired();
@@ -111,6 +123,9 @@ namespace riner {
          * @return whether solution would be accepted by the pool protocol implementation
          */
         bool valid() const {
+            if (expiryToken) { //queue (and therefore the pool) still exists and the job was not cleared
+                return !expiryToken->isClosed() && !expiryToken->isInvalid(jobId) && !job.expired();
+            }
             //checks whether associated shared_ptrs are still alive
             bool valid = false;
             if (auto sharedPtr = job.lock())
@@ -129,15 +144,21 @@ namespace riner {
     class Work {
 
         std::weak_ptr<const PoolJob> job;
+        std::shared_ptr<const ExpiryToken> expiryToken; //assigned by the queue together with job, may be nullptr
+        int64_t jobId = 0; //snapshot of job->id, compared against the expiryToken's latest job id
         friend class WorkQueue;
         friend class LazyWorkQueue;
         friend class WorkSolution;
 
     protected:
-        Work(const std::string &powType);
+        /**
+         * @param powTypeId id of the subclass' PowType, e.g. `PowTypeIdOf<HasPowTypeEthash>::value`
+         */
+        explicit Work(PowTypeId powTypeId);
 
     public:
-        const std::string powType;
+        const PowTypeId powTypeId; //see PowType.h, compared by downCast() instead of the PowType string
+
         virtual ~Work() = default;
 
         /**
@@ -146,7 +167,7 @@ namespace riner {
         template<class T>
         T *downCast() {
             static_assert(std::is_base_of<Work, T>::value, "");
-            return T::getPowType() == powType ? static_cast<T*>(this) : nullptr;
+            return PowTypeIdOf<T>::value == powTypeId ? static_cast<T*>(this) : nullptr;
         }
 
         /**
@@ -155,7 +176,7 @@ namespace riner {
         template<class T>
         const T *downCast() const {
             static_assert(std::is_base_of<Work, T>::value, "");
-            return T::getPowType() == powType ? static_cast<const T*>(this) : nullptr;
+            return PowTypeIdOf<T>::value == powTypeId ? static_cast<const T*>(this) : nullptr;
         }
 
         /**
@@ -174,6 +195,9 @@ namespace riner {
          * @return whether the work has been marked expired by the pool protocol implementation
          */
         bool expired() const { //thread safe
+            if (expiryToken) {
+                return expiryToken->isExpired(jobId); //single atomic load, cheap enough to call after every kernel launch
+            }
             bool expired = true;
             if (auto sharedPtr = job.lock())
                 expired = sharedPtr->expired();
@@ -187,6 +211,9 @@ namespace riner {
          * @return whether a solution for this work would be accepted by the pool protocol implementation
          */
         bool valid() const {
+            if (expiryToken) { //queue (and therefore the pool) still exists and the job was not cleared
+                return !expiryToken->isClosed() && !expiryToken->isInvalid(jobId) && !job.expired();
+            }
             //checks whether associated shared_ptrs are still alive
             bool valid = false;
             if (auto sharedPtr = job.lock())
@@ -194,6 +221,21 @@ namespace riner {
             return valid;
         }
 
+        /**
+         * @brief blocks until this work expires or the timeout is reached.
+         * The waiting thread is woken up as soon as the pool pushes a newer job (e.g. a job with clean flag), so
+         * algorithms that wait for their device can use this instead of sleeping to react to new jobs immediately.
+         *
+         * @return whether the work is expired
+         */
+        bool waitUntilExpired(std::chrono::steady_clock::duration timeout) const {
+            if (expiryToken) {
+                return expiryToken->waitForExpiry(jobId, timeout);
+            }
+            std::this_thread::sleep_for(timeout);
+            return expired();
+        }
+
 
         /**
          * @brief creates a solution object for this work object.
@@ -208,7 +250,8 @@ namespace riner {
          *
          * @tparam WorkSolutionT Type of the Solution object that corresponds to this work's dynamic type (e.g. WorkSolutionEthash for WorkEthash).
          *
-         * @return a WorkSolutionT wrapped in a unique_ptr in order to allow passing it later in a type erased fashion (as unique_ptr<WorkSolution>) without slicing
+         * @return a WorkSolutionT wrapped in a unique_ptr in order to allow passing it later in a type erased fashion (as unique_ptr<WorkSolution>) without slicing.
+         * if WorkSolutionT inherits from Recyclable<WorkSolutionT> its memory comes from a per-type free list
          */
         template<class WorkSolutionT>
         unique_ptr<WorkSolutionT> makeWorkSolution() const {
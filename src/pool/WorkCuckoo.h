@@ -4,6 +4,7 @@
 #include <src/pool/Pool.h>
 #include <src/pool/Work.h>
 #include <src/util/Bytes.h>
+#include <src/util/RecyclingPool.h>
 
 #include <vector>
 
@@ -29,23 +30,39 @@ struct HasPowTypeCuckatoo<31> {
 
 
 template<class PowTypeT>
-class WorkCuckoo : public Work, public PowTypeT {
+class WorkCuckoo : public Work, public PowTypeT, public Recyclable<WorkCuckoo<PowTypeT>> {
 public:
-    WorkCuckoo() :
-            Work(PowTypeT::getPowType()) {
+    static std::string recyclingPoolName() {
+        return std::string("WorkCuckoo ") + PowTypeT::getPowType();
     }
 
-    int64_t difficulty = 1;
-    std::vector<uint8_t> prePow;
+    /**
+     * per-job data, shared immutably by all WorkCuckoo objects made from the same PoolJob
+     */
+    struct JobData {
+        int64_t difficulty = 1;
+        std::vector<uint8_t> prePow;
+    };
+
+    explicit WorkCuckoo(std::shared_ptr<const JobData> data) :
+            Work(PowTypeIdOf<PowTypeT>::value),
+            data(std::move(data)) {
+    }
+
+    std::shared_ptr<const JobData> data; //never nullptr
 
     uint64_t nonce = 0;
 };
 
 template<class PowTypeT>
-class WorkSolutionCuckoo : public WorkSolution, public PowTypeT {
+class WorkSolutionCuckoo : public WorkSolution, public PowTypeT, public Recyclable<WorkSolutionCuckoo<PowTypeT>> {
 public:
     using work_type = WorkCuckoo<PowTypeT>;
 
+    static std::string recyclingPoolName() {
+        return std::string("WorkSolutionCuckoo ") + PowTypeT::getPowType();
+    }
+
     WorkSolutionCuckoo(const WorkCuckoo<PowTypeT> &work) :
             WorkSolution(static_cast<const Work&>(work)) {
     }
@@ -32,8 +32,9 @@ namespace riner {
 
         //We need to tell the base class what our PowType is, so that riner can
         //tell us if we accidentially try to plug together a Pool of PowType A
-        //with an Algo of PowType B
-        WorkDummy() : Work(getPowType()) {
+        //with an Algo of PowType B.
+        //PowTypeIdOf turns the PowType string into an integer id at compile time, so these checks stay cheap
+        WorkDummy() : Work(PowTypeIdOf<HasPowTypeDummy>::value) {
         }
 
         //The Work instances will most likely end up in a WorkQueue at some point
@@ -69,6 +70,9 @@ namespace riner {
         //do not put pool communication related things like job-id here (see PoolJob for that).
         uint64_t nonce = 0;
 
+        //makeWorkSolution<WorkSolutionDummy>() needs to know which Work type this solution belongs to
+        using work_type = WorkDummy;
+
         //for makeWorkSolution<...>(...) to work, we need to provide it with a
         //constructor like below, that takes a WorkDummy and hands it to the base class.
         WorkSolutionDummy(const WorkDummy &work)
@@ -8,6 +8,7 @@
 #include <src/common/Span.h>
 #include <src/algorithm/ethash/DagCache.h>
 #include <src/util/DifficultyTarget.h>
+#include <src/util/RecyclingPool.h>
 
 namespace riner {
 
@@ -18,50 +19,64 @@ namespace riner {
         }
     };
 
-    class WorkEthash : public Work, public HasPowTypeEthash {
+    class WorkEthash : public Work, public HasPowTypeEthash, public Recyclable<WorkEthash> {
     public:
-
-        WorkEthash() : Work(getPowType()) {
+        static std::string recyclingPoolName() {
+            return "WorkEthash";
         }
 
-        Bytes<32> header;
-        Bytes<32> seedHash;
-        Bytes<32> jobTarget; //actual target of the PoolJob
-        Bytes<32> deviceTarget; //easier target than above for GPUs
-
-        double jobDifficulty;
-        double deviceDifficulty = 60e6; //60 Mh, roughly 2s on a GPU
-
-        uint32_t epoch = std::numeric_limits<uint32_t>::max();
-        uint32_t extraNonce;
-
         /**
-         * setEpoch is called on the work templte in the Ethash Pool's workQueue, so that the epoch calculation doesn't happen on the io thread, but the queue's refill thread instead
+         * per-job data that is the same for every WorkEthash of a PoolJob. It is filled once by the pool and then
+         * shared (immutably) by all WorkEthash objects made from that job, so that making work only copies a pointer
          */
-        void setEpoch() {
-            if (epoch == std::numeric_limits<uint32_t>::max()) {
-                epoch = calculateEthEpoch(seedHash); //expensive-ish
+        struct JobData {
+            Bytes<32> header;
+            Bytes<32> seedHash;
+            Bytes<32> jobTarget; //actual target of the PoolJob
+            //the (easier) device target for GPUs is chosen per device by the AlgoImpl, see DifficultyController
+
+            double jobDifficulty;
+
+            uint32_t epoch = std::numeric_limits<uint32_t>::max();
+
+            /**
+             * setEpoch is called on the job data in the Ethash Pool's workQueue, so that the epoch calculation doesn't happen on the io thread, but the queue's refill thread instead
+             */
+            void setEpoch() {
+                if (epoch == std::numeric_limits<uint32_t>::max()) {
+                    epoch = calculateEthEpoch(seedHash); //expensive-ish
+                }
             }
-        }
 
-        /**
-         * called to finish initializing by setting difficulty related members
-         */
-        void setDifficultiesAndTargets(const Bytes<32> &jobTarget) {
-            jobDifficulty = targetToDifficultyApprox(jobTarget);
-            this->jobTarget = jobTarget;
-            deviceDifficulty = std::min(deviceDifficulty, jobDifficulty); //make sure deviceDiff is not harder than jobDiff
-            deviceTarget = difficultyToTargetApprox(deviceDifficulty);
+            /**
+             * called to finish initializing by setting difficulty related members
+             */
+            void setDifficultiesAndTargets(const Bytes<32> &jobTarget) {
+                jobDifficulty = targetToDifficultyApprox(jobTarget);
+                this->jobTarget = jobTarget;
+            }
+        };
+
+        explicit WorkEthash(std::shared_ptr<const JobData> data)
+                : Work(PowTypeIdOf<HasPowTypeEthash>::value)
+                , data(std::move(data)) {
         }
+
+        std::shared_ptr<const JobData> data; //never nullptr
+        uint32_t extraNonce = 0; //the only per-work data, makes the nonce space of each WorkEthash unique
     };
 
-    class WorkSolutionEthash : public WorkSolution, public HasPowTypeEthash {
+    class WorkSolutionEthash : public WorkSolution, public HasPowTypeEthash, public Recyclable<WorkSolutionEthash> {
     public:
         using work_type = WorkEthash;
 
+        static std::string recyclingPoolName() {
+            return "WorkSolutionEthash";
+        }
+
         WorkSolutionEthash(const WorkEthash &work)
                 : WorkSolution(static_cast<const Work&>(work))
-                , jobDifficulty(work.jobDifficulty) {
+                , jobDifficulty(work.data->jobDifficulty) {
         }
 
         Bytes<32> header;
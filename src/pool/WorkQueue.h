@@ -7,12 +7,15 @@
 #include <src/common/Pointers.h>
 #include <src/common/Assert.h>
 #include <src/util/Logging.h>
+#include <src/util/MpmcRing.h>
+#include <src/pool/ExpiryToken.h>
 #include <atomic>
 #include <queue>
 #include <list>
 #include <functional>
 #include <chrono>
 #include <future>
+#include <vector>
 
 
 namespace riner {
@@ -28,13 +31,17 @@ namespace riner {
         friend struct PoolJob;
 
     protected:
-        std::atomic_int64_t latestJobId {0};
+        std::shared_ptr<ExpiryToken> expiry = std::make_shared<ExpiryToken>(); //shared with all Work made by this queue
         std::mutex mutex;
         std::deque<std::shared_ptr<PoolJob>> jobQueue;
 
     public:
 
-        void pushJob(std::unique_ptr<PoolJob> newJob, bool cleanFlag = false) {
+        ~LazyWorkQueue() {
+            expiry->close(); //work that outlives this queue is expired and invalid
+        }
+
+        void pushJob(std::shared_ptr<PoolJob> newJob, bool cleanFlag = false) {
 
             std::lock_guard<std::mutex> lock(mutex);
             if (cleanFlag) {
@@ -44,7 +51,10 @@ namespace riner {
                 //limit the max. size of the jobQueue so that really old jobs are dropped
                 jobQueue.resize(std::min(jobQueue.size(), size_t(7)));
             }
-            newJob->id = latestJobId.fetch_add(1, std::memory_order_relaxed) + 1;
+            newJob->id = expiry->expireAll(); //also wakes up threads waiting in Work::waitUntilExpired
+            if (cleanFlag) {
+                expiry->invalidateBefore(newJob->id); //the pool may still hold on to the cleared jobs
+            }
             jobQueue.emplace_front(std::move(newJob));
 
         }
@@ -55,26 +65,29 @@ namespace riner {
                 return nullptr;
             std::unique_ptr<Work> work = jobQueue.front()->makeWork(); //NOTE: this is a callback into user code while a lock is being held
             work->job = jobQueue.front();
+            work->expiryToken = expiry;
+            work->jobId = jobQueue.front()->id;
             return work;
         }
 
         inline bool isExpiredJob(const PoolJob &job) {
-            return latestJobId.load(std::memory_order_relaxed) != job.id;
+            return expiry->isExpired(job.id);
         }
 
         /**
-         * @brief clears the job queue
+         * @brief clears the job queue, all Work from this queue is marked as expired
          */
         inline void clear() {
             std::unique_lock<std::mutex> lock(mutex);
             jobQueue.clear();
+            expiry->invalidateBefore(expiry->expireAll());
         }
 
         /**
-         * @brief increases the latestJobId counter, so that all Work from this queue is marked as expired
+         * @brief increases the latest job id, so that all Work from this queue is marked as expired
          */
         inline void expireJobs() {
-            latestJobId.fetch_add(1, std::memory_order_relaxed);
+            expiry->expireAll();
         }
     };
 
@@ -84,13 +97,17 @@ namespace riner {
      * This queue returns work from a work queue, which is filled asyncronously by a batch operation.
      * Use this queue if the implemenation of PoolJob::makeWork() is complex, i.e. when it performs
      * cryptographic hash calculations or when it could block.
+     *
+     * The generated Work is stored in a lock-free ring, so that algorithm threads only pop from the ring
+     * and do not contend on the mutex as long as work is available. The mutex/condition variables are only
+     * used by the refill thread and by consumers that have to wait for an empty ring to be refilled.
      */
     class WorkQueue {
 
         friend struct PoolJob;
 
     protected:
-        std::atomic_int64_t latestJobId {0};
+        std::shared_ptr<ExpiryToken> expiry = std::make_shared<ExpiryToken>(); //shared with all Work made by this queue
         std::mutex mutex;
         bool shutdown {false};
         std::deque<std::shared_ptr<PoolJob>> jobQueue;
@@ -98,7 +115,8 @@ namespace riner {
     public:
 
         WorkQueue(size_t refillThreshold = 8, size_t maxWorkQueueLength = 16)
-                : refillThreshold(refillThreshold) {
+                : buffer(maxWorkQueueLength)
+                , refillThreshold(refillThreshold) {
 
             refillTask = std::async(std::launch::async, [this, refillThreshold, maxWorkQueueLength] {
 
@@ -112,9 +130,11 @@ namespace riner {
                     size_t currentSize = 0;
 
                     notifyNeedsRefill.wait(lock, [&] {
+                        //reset before checking the size, so that a popping thread which lowers the size afterwards notifies again
+                        refillRequested.store(false, std::memory_order_relaxed);
                         bool jobExists = !jobQueue.empty();
                         bool hasNewJob = jobExists && latestId != jobQueue.front()->id;
-                        bool belowThreshold = buffer.size() < refillThreshold;
+                        bool belowThreshold = buffer.sizeApprox() < refillThreshold;
 
                         return (belowThreshold && jobExists) || hasNewJob || shutdown;
                     });
@@ -126,30 +146,30 @@ namespace riner {
                     auto latestJob = jobQueue.front();
                     bool hasNewJob = latestId != latestJob->id;
                     latestId = latestJob->id;
-                    currentSize = buffer.size();
+                    currentSize = buffer.sizeApprox();
 
                     lock.unlock();
                     for (size_t size = hasNewJob ? 0 : currentSize; size < maxWorkQueueLength; size++) {
                         toBeFilled.push_back(latestJob->makeWork());
                         toBeFilled.back()->job = latestJob;
+                        toBeFilled.back()->expiryToken = expiry;
+                        toBeFilled.back()->jobId = latestId;
                     }
                     lock.lock();
 
                     //if a new latestJob was set then ignore the newly generated work
                     if (!jobQueue.empty() && latestId == jobQueue.front()->id) {
                         if (hasNewJob) {
-                            buffer.clear();
+                            drainBuffer();
                         }
 
                         for (auto &newElement : toBeFilled) {
-                            buffer.push_front(std::move(newElement));
-                        }
-
-                        if (hasNewJob) {
-                            latestJobId.store(latestId);
+                            if (!buffer.tryPush(std::move(newElement))) {
+                                break; //ring is full, drop the rest
+                            }
                         }
 
-                        notifyNotEmptyAnymore.notify_all(); //notify popTimeout threads they will be able to
+                        notifyNotEmptyAnymore.notify_all(); //notify waiting pop threads, they will be able to
                         // acquire the lock once its unlocked in this task's notifyNeedsRefill.wait(...)
                     }
                     toBeFilled.clear();
@@ -163,25 +183,29 @@ namespace riner {
                 shutdown = true;
             }
             notifyNeedsRefill.notify_one(); //wake up refillTask thread so it notices shutdown == true
+            expiry->close(); //work that outlives this queue is expired and invalid
         }
 
         /*
          * sets a new most-recent job that "job->makeWork()" will be called upon, to refill the queue if it gets empty.
-         * the cleanFlag can be set to clear all existing contents of the workQueue (while holding the lock), so AlgoImpls
-         * won't get outdated jobs upon calling popWithTimeout().
+         * Work of older jobs expires immediately and is dropped from the queue, so AlgoImpls won't get outdated work
+         * upon calling popWithTimeout(). The cleanFlag can be set to also invalidate the older jobs.
          */
-        void pushJob(std::unique_ptr<PoolJob> newJob, bool cleanFlag = false) {
+        void pushJob(std::shared_ptr<PoolJob> newJob, bool cleanFlag = false) {
             {
                 std::lock_guard<std::mutex> lock(mutex);
                 if (cleanFlag) {
                     jobQueue.clear();
-                    buffer.clear();
                 }
                 else {
                     //limit the max. size of the jobQueue so that really old jobs are dropped
                     jobQueue.resize(std::min(jobQueue.size(), size_t(7)));
                 }
-                newJob->id = ++currentId;
+                drainBuffer();
+                newJob->id = expiry->expireAll(); //also wakes up threads waiting in Work::waitUntilExpired
+                if (cleanFlag) {
+                    expiry->invalidateBefore(newJob->id); //the pool may still hold on to the cleared jobs
+                }
                 jobQueue.emplace_front(std::move(newJob));
             }
 
@@ -195,28 +219,24 @@ namespace riner {
          * @return a work object created by jobs in the jobQueue via job->makeWork() or nullptr if timeout happened
          */
         unique_ptr<Work> popWithTimeout(std::chrono::steady_clock::duration timeoutDuration = std::chrono::milliseconds(100)) {
-            size_t currentSize = 0;
-            bool hasMaster = false;
+            //lock-free fast path, falls back to waiting on notifyNotEmptyAnymore only if the ring is empty
             unique_ptr<Work> result;
-
-            {
+            if (!buffer.tryPop(result)) {
                 std::unique_lock<std::mutex> lock(mutex);
 
-                bool timedOut = !notifyNotEmptyAnymore.wait_for(lock, timeoutDuration, [this] {
-                    return !buffer.empty();
+                //the refill thread pushes while holding the mutex, so checking the ring in the predicate cannot miss a notification
+                bool timedOut = !notifyNotEmptyAnymore.wait_for(lock, timeoutDuration, [&] {
+                    return buffer.tryPop(result) || shutdown;
                 });
 
-                if (timedOut)
+                if (timedOut || !result)
                     return nullptr;
+            }
 
-                result = std::move(buffer.back());
-                buffer.pop_back();
-
-                hasMaster = !jobQueue.empty();
-                currentSize = buffer.size();
-            }//unlock
-
-            if (currentSize < refillThreshold && hasMaster) {
+            if (buffer.sizeApprox() < refillThreshold && !refillRequested.exchange(true, std::memory_order_relaxed)) {
+                //taking the lock once before notifying prevents a lost wakeup if the refill thread is
+                //just evaluating its wait predicate
+                { std::lock_guard<std::mutex> lock(mutex); }
                 notifyNeedsRefill.notify_one();
             }
 
@@ -227,35 +247,46 @@ namespace riner {
          * @return whether the job is the latest job in the jobQueue
          */
         inline bool isExpiredJob(const PoolJob &job) {
-            return latestJobId.load(std::memory_order_relaxed) != job.id;
+            return expiry->isExpired(job.id);
         }
 
 
         /**
-         * @brief clears the job queue
+         * @brief clears the job queue, all Work from this queue is marked as expired
          */
         inline void clear() {
             std::unique_lock<std::mutex> lock(mutex);
             jobQueue.clear();
+            drainBuffer();
+            expiry->invalidateBefore(expiry->expireAll());
         }
 
         /**
-         * @brief increases the latestJobId counter, so that all Work from this queue is marked as expired
+         * @brief increases the latest job id, so that all Work from this queue is marked as expired
          */
         inline void expireJobs() {
-            latestJobId.fetch_add(1, std::memory_order_relaxed);
+            expiry->expireAll();
         }
 
     private:
         std::condition_variable notifyNotEmptyAnymore;
         std::condition_variable notifyNeedsRefill;
-        int64_t currentId {0};
 
-        std::deque<std::unique_ptr<Work>> buffer;
+        MpmcRing<std::unique_ptr<Work>> buffer; //pushed to by the refill thread only, popped from by any thread
 
-        size_t refillThreshold; //once buffer.size() goes below this value, needs refill is notified
+        size_t refillThreshold; //once buffer.sizeApprox() goes below this value, needs refill is notified
+        std::atomic_bool refillRequested {false}; //so that only one popping thread takes the lock to notify the refill thread
 
         std::future<void> refillTask;
+
+        /**
+         * pops all elements of the ring. Only called while holding the mutex, so that no new work is pushed meanwhile
+         */
+        void drainBuffer() {
+            unique_ptr<Work> discarded;
+            while (buffer.tryPop(discarded)) {
+            }
+        }
     };
 
 }
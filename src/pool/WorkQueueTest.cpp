@@ -0,0 +1,118 @@
+
+#include <src/pool/WorkQueue.h>
+#include <src/pool/WorkDummy.h>
+
+#include <gtest/gtest.h>
+#include <set>
+
+namespace riner {
+namespace {
+
+struct CountingJob : public PoolJob {
+    std::atomic<uint64_t> madeWork {0};
+
+    CountingJob() : PoolJob(std::weak_ptr<Pool>{}) {
+    }
+
+    unique_ptr<Work> makeWork() override {
+        auto work = std::make_unique<WorkDummy>();
+        work->nonce_begin = madeWork++;
+        return work;
+    }
+};
+
+TEST(WorkQueue, PopTimesOutWithoutJob) {
+    WorkQueue queue;
+    EXPECT_EQ(queue.popWithTimeout(std::chrono::milliseconds(10)), nullptr);
+}
+
+TEST(WorkQueue, PopReturnsUniqueWork) {
+    WorkQueue queue(4, 8);
+    queue.pushJob(std::make_unique<CountingJob>());
+
+    std::set<uint64_t> nonces;
+    for (int i = 0; i < 30; ++i) {
+        auto work = queue.popWithTimeout(std::chrono::seconds(5));
+        ASSERT_NE(work, nullptr);
+        EXPECT_TRUE(nonces.insert(work->downCast<WorkDummy>()->nonce_begin).second);
+    }
+}
+
+TEST(WorkQueue, CleanFlagDropsBufferedWork) {
+    WorkQueue queue(4, 8);
+    queue.pushJob(std::make_unique<CountingJob>());
+    auto oldWork = queue.popWithTimeout(std::chrono::seconds(5));
+    ASSERT_NE(oldWork, nullptr);
+    auto oldJobId = oldWork->tryGetJob()->id;
+
+    auto newJob = std::make_unique<CountingJob>();
+    queue.pushJob(std::move(newJob), true);
+
+    for (int i = 0; i < 10; ++i) {
+        auto work = queue.popWithTimeout(std::chrono::seconds(5));
+        ASSERT_NE(work, nullptr);
+        auto job = work->tryGetJob();
+        ASSERT_NE(job, nullptr);
+        EXPECT_NE(job->id, oldJobId);
+    }
+    EXPECT_EQ(oldWork->tryGetJob(), nullptr); //clean job dropped the old PoolJob
+}
+
+TEST(WorkQueue, CleanJobWakesUpExpiryWaiters) {
+    WorkQueue queue(4, 8);
+    queue.pushJob(std::make_unique<CountingJob>());
+    auto work = queue.popWithTimeout(std::chrono::seconds(5));
+    ASSERT_NE(work, nullptr);
+    EXPECT_FALSE(work->expired());
+    EXPECT_FALSE(work->waitUntilExpired(std::chrono::milliseconds(1)));
+
+    auto pushTask = std::async(std::launch::async, [&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        queue.pushJob(std::make_unique<CountingJob>(), true);
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(work->waitUntilExpired(std::chrono::seconds(10)));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    EXPECT_TRUE(work->expired());
+    EXPECT_FALSE(work->valid());
+}
+
+TEST(WorkQueue, JobIdsGrowAcrossPushesAndClears) {
+    WorkQueue queue(4, 8);
+    queue.pushJob(std::make_unique<CountingJob>());
+    auto workA = queue.popWithTimeout(std::chrono::seconds(5));
+    ASSERT_NE(workA, nullptr);
+
+    queue.pushJob(std::make_unique<CountingJob>());
+    EXPECT_TRUE(workA->expired()); //right away, not only once work of the new job was made
+    EXPECT_TRUE(workA->valid());
+    auto workB = queue.popWithTimeout(std::chrono::seconds(5));
+    ASSERT_NE(workB, nullptr);
+    auto jobIdB = workB->tryGetJob()->id;
+    EXPECT_GT(jobIdB, workA->tryGetJob()->id); //work of the old job was dropped from the queue
+
+    queue.clear();
+    queue.pushJob(std::make_unique<CountingJob>());
+    auto workC = queue.popWithTimeout(std::chrono::seconds(5));
+    ASSERT_NE(workC, nullptr);
+    EXPECT_GT(workC->tryGetJob()->id, jobIdB);
+    EXPECT_FALSE(workC->expired());
+    EXPECT_FALSE(workB->valid());
+}
+
+TEST(WorkQueue, WorkOutlivingQueueIsInvalid) {
+    unique_ptr<Work> work;
+    {
+        WorkQueue queue(4, 8);
+        queue.pushJob(std::make_unique<CountingJob>());
+        work = queue.popWithTimeout(std::chrono::seconds(5));
+        ASSERT_NE(work, nullptr);
+        EXPECT_TRUE(work->valid());
+    }
+    EXPECT_TRUE(work->expired());
+    EXPECT_FALSE(work->valid());
+}
+
+} // namespace
+} // riner
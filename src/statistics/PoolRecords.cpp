@@ -30,12 +30,28 @@ namespace riner {
         });
     }
 
+    void PoolRecords::reportStaleShare(double difficulty) {
+        auto now = clock::now();
+        _node.lockedForEach([=] (Data &d) {
+            d.staleShares.addRecord(difficulty, now);
+        });
+    }
+
+    void PoolRecords::reportOrphanedShare(double difficulty) {
+        auto now = clock::now();
+        _node.lockedForEach([=] (Data &d) {
+            d.orphanedShares.addRecord(difficulty, now);
+        });
+    }
+
     void PoolRecords::resetInterval() {
         _node.lockedApply([](Data &data) {
             clock::time_point time = clock::now();
             data.acceptedShares.getAndReset(time);
             data.rejectedShares.getAndReset(time);
             data.duplicateShares.getAndReset(time);
+            data.staleShares.getAndReset(time);
+            data.orphanedShares.getAndReset(time);
         });
     }
 
@@ -43,4 +59,21 @@ namespace riner {
         return acceptedShares.interval.getElapsedTime(clock::now());
     }
 
+    double PoolRecords::Data::effectiveShareOf(const Data &total) const {
+        double totalDifficulty = total.acceptedShares.mean.getTotalWeight();
+        if (totalDifficulty <= 0) {
+            return 0;
+        }
+        return acceptedShares.mean.getTotalWeight() / totalDifficulty;
+    }
+
+    double PoolRecords::Data::rejectedRatio() const {
+        auto rejected = rejectedShares.mean.getTotal();
+        auto total = acceptedShares.mean.getTotal() + rejected;
+        if (total == 0) {
+            return 0;
+        }
+        return double(rejected) / total;
+    }
+
 }
@@ -36,12 +36,26 @@ namespace riner {
         struct Data {
             Averages acceptedShares;
             Averages rejectedShares;
-            Averages duplicateShares;
+            Averages duplicateShares; //shares that were dropped locally because they were already submitted, or that the pool rejected as a duplicate of an earlier try
+            Averages staleShares; //shares that were dropped locally because their job was outdated (see StaleSharePolicy)
+            Averages orphanedShares; //shares that were dropped locally because their job was already forgotten by the pool
 
             /**
              * returns a pool connection duration estimate based on accepted shares time interval
              */
             clock::duration connectionDuration() const;
+
+            /**
+             * returns the fraction of `total`'s accepted difficulty that was accepted by this pool, e.g. 0.7 if a
+             * pool got 70% of the hashrate of its PoolSwitcher (whose records are `total`)
+             */
+            double effectiveShareOf(const Data &total) const;
+
+            /**
+             * returns the fraction of submitted shares that were rejected by the pool (e.g. because they were stale)
+             * or 0 if no shares were submitted yet. Duplicates don't count, they either never reach the pool or are resent tries
+             */
+            double rejectedRatio() const;
         };
 
         PoolRecords() = default;
@@ -50,10 +64,22 @@ namespace riner {
 
         /**
          * call this method to report that a share of a certain difficulty was sent to
-         * the pool and whether the pool accepted it (and whether it was a duplicate or not)
+         * the pool and whether the pool accepted it, or that it was a duplicate (not sent at all, or rejected as a duplicate
+         * of an earlier try of the same submit)
          */
         void reportShare(double difficulty, bool isAccepted, bool isDuplicate);
 
+        /**
+         * call this method to report that a share was not sent to the pool because its job was outdated
+         */
+        void reportStaleShare(double difficulty);
+
+        /**
+         * call this method to report that a share was not sent to the pool because its job was already forgotten, so
+         * that no StaleSharePolicy could decide about it
+         */
+        void reportOrphanedShare(double difficulty);
+
         Data read() const;
         
         /**
@@ -0,0 +1,43 @@
+//
+//
+
+#include "DifficultyController.h"
+#include <src/common/Assert.h>
+#include <algorithm>
+
+namespace riner {
+
+    DifficultyController::DifficultyController(double candidatesPerMinute, double initialDifficulty)
+            : _candidatesPerMinute(candidatesPerMinute)
+            , _difficulty(initialDifficulty) {
+        RNR_EXPECTS(candidatesPerMinute > 0);
+        RNR_EXPECTS(initialDifficulty >= 1);
+    }
+
+    void DifficultyController::reportScannedNonces(uint64_t amount, clock::time_point now) {
+        const auto window = seconds(2); //measure the nonce rate over at least this duration
+        const double smoothing = 0.25; //weight of the latest window in the smoothed nonce rate
+        const double minDifficulty = 1;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_inUse.exchange(true, std::memory_order_relaxed)) {
+            _windowStart = now; //the first batch's runtime is unknown, start measuring at its end
+            return;
+        }
+
+        _windowNonces += amount;
+        auto elapsed = now - _windowStart;
+        if (elapsed < window) {
+            return;
+        }
+
+        double rate = _windowNonces / std::chrono::duration<double>(elapsed).count();
+        _smoothedNonceRate = _smoothedNonceRate == 0 ? rate : (1 - smoothing) * _smoothedNonceRate + smoothing * rate;
+        _windowStart = now;
+        _windowNonces = 0;
+
+        double difficulty = _smoothedNonceRate * 60 / _candidatesPerMinute;
+        _difficulty.store(std::max(difficulty, minDifficulty), std::memory_order_relaxed);
+    }
+
+}
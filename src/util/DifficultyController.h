@@ -0,0 +1,68 @@
+//
+//
+
+#pragma once
+
+#include <src/common/Chrono.h>
+#include <src/util/Copy.h>
+#include <atomic>
+#include <mutex>
+
+namespace riner {
+
+    /**
+     * @brief chooses the difficulty of a device's target (e.g. ethash's deviceTarget) so that the device finds a fixed
+     * amount of candidate solutions per minute, independent of its hashrate.
+     * Every candidate gets verified on the CPU, so more candidates detect hardware errors earlier and give a smoother
+     * hashrate estimate, but cost more CPU time. A fixed device difficulty makes fast GPUs flood the CPU while slow
+     * GPUs hardly ever get checked.
+     * The difficulty is derived from the measured nonce rate (the expected amount of candidates per scanned nonce is
+     * 1 / difficulty), which is smoothed to not follow every fluctuation of the kernel runtime.
+     * All methods are thread-safe.
+     */
+    class DifficultyController {
+    public:
+        /**
+         * @param candidatesPerMinute targeted amount of candidate solutions per minute
+         * @param initialDifficulty difficulty that is used until the first nonce rate measurement is available
+         */
+        explicit DifficultyController(double candidatesPerMinute, double initialDifficulty = 60e6);
+
+        DELETE_COPY_AND_MOVE(DifficultyController);
+
+        /**
+         * call this whenever the device finished scanning a batch of nonces (e.g. after each kernel run)
+         */
+        void reportScannedNonces(uint64_t amount, clock::time_point now = clock::now());
+
+        /**
+         * @return the device difficulty that currently results in the targeted candidate rate. The caller still needs
+         * to make sure that the device target is not harder than the job's target
+         */
+        inline double getDifficulty() const {
+            return _difficulty.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @return whether any nonces were reported yet, i.e. whether an algorithm uses this controller
+         */
+        inline bool isInUse() const {
+            return _inUse.load(std::memory_order_relaxed);
+        }
+
+        inline double getCandidatesPerMinute() const {
+            return _candidatesPerMinute;
+        }
+
+    private:
+        const double _candidatesPerMinute;
+        std::atomic<double> _difficulty;
+        std::atomic_bool _inUse {false};
+
+        std::mutex _mutex;
+        clock::time_point _windowStart;
+        uint64_t _windowNonces = 0;
+        double _smoothedNonceRate = 0; //nonces per second, 0 until the first window is complete
+    };
+
+}
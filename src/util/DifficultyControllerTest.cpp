@@ -0,0 +1,60 @@
+
+#include <src/util/DifficultyController.h>
+
+#include <gtest/gtest.h>
+
+namespace riner {
+namespace {
+
+/**
+ * simulates a device that scans `noncesPerSecond` in batches of `batchDuration` for `duration`
+ * @return the simulated point in time after the last batch
+ */
+clock::time_point simulateDevice(DifficultyController &controller, double noncesPerSecond, clock::time_point start,
+        clock::duration duration, clock::duration batchDuration = milliseconds(100)) {
+    auto batchNonces = static_cast<uint64_t>(noncesPerSecond * std::chrono::duration<double>(batchDuration).count());
+    auto time = start;
+    for (; time < start + duration; time += batchDuration) {
+        controller.reportScannedNonces(batchNonces, time);
+    }
+    return time;
+}
+
+TEST(DifficultyController, UsesInitialDifficultyUntilMeasured) {
+    DifficultyController controller {30, 60e6};
+    EXPECT_FALSE(controller.isInUse());
+    EXPECT_EQ(controller.getDifficulty(), 60e6);
+
+    controller.reportScannedNonces(1000000, clock::now());
+    EXPECT_TRUE(controller.isInUse());
+    EXPECT_EQ(controller.getDifficulty(), 60e6);
+}
+
+TEST(DifficultyController, TargetsCandidatesPerMinute) {
+    const double candidatesPerMinute = 30;
+    DifficultyController slow {candidatesPerMinute};
+    DifficultyController fast {candidatesPerMinute};
+
+    auto start = clock::now();
+    simulateDevice(slow, 10e6, start, seconds(60));
+    simulateDevice(fast, 100e6, start, seconds(60));
+
+    //expected candidates per minute = noncesPerSecond * 60 / difficulty
+    EXPECT_NEAR(10e6 * 60 / slow.getDifficulty(), candidatesPerMinute, candidatesPerMinute * 0.02);
+    EXPECT_NEAR(100e6 * 60 / fast.getDifficulty(), candidatesPerMinute, candidatesPerMinute * 0.02);
+}
+
+TEST(DifficultyController, FollowsHashrateChanges) {
+    const double candidatesPerMinute = 60;
+    DifficultyController controller {candidatesPerMinute};
+
+    auto time = simulateDevice(controller, 50e6, clock::now(), seconds(60));
+    EXPECT_NEAR(controller.getDifficulty(), 50e6, 50e6 * 0.02);
+
+    //e.g. the gpu throttles because of its temperature
+    simulateDevice(controller, 20e6, time, seconds(60));
+    EXPECT_NEAR(controller.getDifficulty(), 20e6, 20e6 * 0.02);
+}
+
+} // namespace
+} // riner
@@ -0,0 +1,141 @@
+//
+//
+#pragma once
+
+#include <src/common/Assert.h>
+#include <src/util/Copy.h>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <algorithm>
+
+namespace riner {
+
+    /**
+     * @brief bounded lock-free multi-producer multi-consumer FIFO ring buffer
+     * Every slot carries a sequence number which tells producers and consumers whether the slot is
+     * ready to be written or read in the current lap around the ring (see D. Vyukov's bounded MPMC queue).
+     * Neither tryPush nor tryPop ever block, they return false if the ring is full/empty instead.
+     * @tparam T element type, must be default constructible and move assignable (e.g. unique_ptr)
+     */
+    template<class T>
+    class MpmcRing {
+
+        static constexpr size_t cacheLineSize = 64;
+
+        struct Slot {
+            std::atomic<size_t> seq;
+            T value;
+        };
+
+        //producer and consumer indices are padded onto separate cache lines so they don't ping-pong between cores.
+        //(padding instead of alignas, since over-aligned heap allocation is not guaranteed before C++17)
+        std::atomic<size_t> _pushPos {0};
+        char _padPush[cacheLineSize - sizeof(std::atomic<size_t>)];
+        std::atomic<size_t> _popPos {0};
+        char _padPop[cacheLineSize - sizeof(std::atomic<size_t>)];
+        const size_t _mask;
+        std::unique_ptr<Slot[]> _slots;
+
+        static size_t roundUpToPowerOfTwo(size_t n) {
+            size_t p = 1;
+            while (p < n)
+                p <<= 1;
+            return p;
+        }
+
+    public:
+
+        /**
+         * @param minCapacity the ring can hold at least this many elements. The actual capacity is rounded up to the next power of two
+         */
+        explicit MpmcRing(size_t minCapacity)
+                : _mask(roundUpToPowerOfTwo(std::max(minCapacity, size_t(2))) - 1)
+                , _slots(new Slot[_mask + 1]) {
+            for (size_t i = 0; i <= _mask; ++i) {
+                _slots[i].seq.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        DELETE_COPY_AND_MOVE(MpmcRing);
+
+        /**
+         * @return max amount of elements that fit into the ring
+         */
+        size_t capacity() const {
+            return _mask + 1;
+        }
+
+        /**
+         * @brief moves value into the ring if there is space left
+         * @return false if the ring is full, in which case value is left untouched
+         */
+        bool tryPush(T &&value) {
+            size_t pos = _pushPos.load(std::memory_order_relaxed);
+            while (true) {
+                Slot &slot = _slots[pos & _mask];
+                size_t seq = slot.seq.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+                if (diff == 0) {
+                    if (_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        slot.value = std::move(value);
+                        slot.seq.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                    //pos was updated by compare_exchange_weak, try again
+                }
+                else if (diff < 0) {
+                    return false; //slot still occupied from the previous lap => full
+                }
+                else {
+                    pos = _pushPos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @brief moves the oldest element out of the ring
+         * @return false if the ring is empty, in which case out is left untouched
+         */
+        bool tryPop(T &out) {
+            size_t pos = _popPos.load(std::memory_order_relaxed);
+            while (true) {
+                Slot &slot = _slots[pos & _mask];
+                size_t seq = slot.seq.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+
+                if (diff == 0) {
+                    if (_popPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        out = std::move(slot.value);
+                        slot.value = T{}; //don't keep moved-from state (e.g. resources) alive in the slot
+                        slot.seq.store(pos + _mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0) {
+                    return false; //slot not yet written in this lap => empty
+                }
+                else {
+                    pos = _popPos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @return amount of elements in the ring. This value may already be outdated when the function returns
+         * if other threads push or pop concurrently, so only use it for heuristics
+         */
+        size_t sizeApprox() const {
+            size_t push = _pushPos.load(std::memory_order_relaxed);
+            size_t pop = _popPos.load(std::memory_order_relaxed);
+            return push > pop ? push - pop : 0;
+        }
+
+        bool emptyApprox() const {
+            return sizeApprox() == 0;
+        }
+
+    };
+
+}
@@ -0,0 +1,59 @@
+//
+//
+
+#pragma once
+
+#include <src/util/Copy.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+namespace riner {
+
+    /**
+     * @brief pointer that is read by many threads and occasionally replaced by a single writer
+     * Reading is a single acquire load (wait-free, no reference counting, no lock), unlike std::atomic_load on a
+     * shared_ptr which takes one of libstdc++'s global spinlocks on every call.
+     * This is RCU with the grace period extended to the lifetime of the PublishedPtr: every object that was ever
+     * published is kept alive until the PublishedPtr is destroyed, so a reader's raw pointer can never dangle while
+     * the PublishedPtr exists. Objects that get published repeatedly are only kept once.
+     * Therefore only use it for a small, bounded set of objects (e.g. the pools of a PoolSwitcher).
+     */
+    template<class T>
+    class PublishedPtr {
+        std::atomic<T *> _ptr {nullptr};
+
+        std::mutex _writerMutex;
+        std::vector<std::shared_ptr<T>> _keepAlive; //every object that was ever published
+
+    public:
+        PublishedPtr() = default;
+        DELETE_COPY_AND_MOVE(PublishedPtr);
+
+        /**
+         * @return the currently published object or nullptr. The object stays alive as long as this PublishedPtr
+         */
+        inline T *get() const {
+            return _ptr.load(std::memory_order_acquire);
+        }
+
+        /**
+         * publish a new object (may be nullptr), readers will see it on their next get()
+         */
+        void set(std::shared_ptr<T> newPtr) {
+            std::lock_guard<std::mutex> lock(_writerMutex);
+            T *raw = newPtr.get();
+
+            if (raw) {
+                auto isSame = [raw] (const std::shared_ptr<T> &p) {return p.get() == raw;};
+                if (std::none_of(_keepAlive.begin(), _keepAlive.end(), isSame)) {
+                    _keepAlive.push_back(std::move(newPtr));
+                }
+            }
+            _ptr.store(raw, std::memory_order_release);
+        }
+    };
+
+}
@@ -0,0 +1,141 @@
+
+#include <src/util/PublishedPtr.h>
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+namespace riner {
+namespace {
+
+struct Counted {
+    static std::atomic<int> alive;
+    const int value;
+
+    explicit Counted(int value) : value(value) {
+        ++alive;
+    }
+    ~Counted() {
+        --alive;
+    }
+};
+
+std::atomic<int> Counted::alive {0};
+
+/**
+ * runs `readerCount` threads that each call read() `iterations` times while the calling thread keeps calling
+ * write() until all readers are done. read() returns an int which is summed up, so the reads can't be optimized away
+ * @return wall time of the whole run
+ */
+template<class ReadFunc, class WriteFunc>
+std::chrono::steady_clock::duration runReaders(size_t readerCount, size_t iterations, ReadFunc &&read, WriteFunc &&write) {
+    std::atomic<size_t> readersDone {0};
+    std::atomic<int64_t> sum {0};
+    std::vector<std::thread> readers;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < readerCount; ++i) {
+        readers.emplace_back([&] {
+            int64_t localSum = 0;
+            for (size_t j = 0; j < iterations; ++j) {
+                localSum += read();
+            }
+            sum += localSum;
+            ++readersDone;
+        });
+    }
+
+    for (int i = 0; readersDone < readerCount; ++i) {
+        write(i);
+        std::this_thread::yield();
+    }
+
+    for (auto &thread : readers) {
+        thread.join();
+    }
+    return std::chrono::steady_clock::now() - start;
+}
+
+TEST(PublishedPtr, KeepsPublishedObjectsAlive) {
+    {
+        PublishedPtr<Counted> ptr;
+        EXPECT_EQ(ptr.get(), nullptr);
+
+        auto a = std::make_shared<Counted>(1);
+        auto b = std::make_shared<Counted>(2);
+        ptr.set(a);
+        ptr.set(b);
+        ptr.set(a);
+        Counted *raw = ptr.get();
+        a.reset();
+        b.reset();
+
+        ASSERT_NE(raw, nullptr);
+        EXPECT_EQ(raw->value, 1);
+        EXPECT_EQ(Counted::alive, 2);
+
+        ptr.set(nullptr);
+        EXPECT_EQ(ptr.get(), nullptr);
+    }
+    EXPECT_EQ(Counted::alive, 0);
+}
+
+TEST(PublishedPtr, ConcurrentReadersSeePublishedObjects) {
+    std::vector<std::shared_ptr<Counted>> objects;
+    for (int i = 0; i < 4; ++i) {
+        objects.push_back(std::make_shared<Counted>(i));
+    }
+
+    PublishedPtr<Counted> ptr;
+    ptr.set(objects[0]);
+    std::atomic<int> badReads {0};
+
+    runReaders(8, 10000, [&] {
+        Counted *c = ptr.get();
+        if (!c || c->value < 0 || c->value >= 4)
+            ++badReads;
+        return 0;
+    }, [&] (int i) {
+        ptr.set(objects[i % objects.size()]);
+    });
+
+    EXPECT_EQ(badReads, 0);
+}
+
+//microbenchmark, run with --gtest_also_run_disabled_tests
+TEST(PublishedPtr, DISABLED_BenchmarkAgainstAtomicSharedPtr) {
+    using namespace std::chrono;
+    const size_t readerCount = 64;
+    const size_t iterations = 200000;
+
+    std::vector<std::shared_ptr<Counted>> objects;
+    for (int i = 0; i < 4; ++i) {
+        objects.push_back(std::make_shared<Counted>(i));
+    }
+
+    std::shared_ptr<Counted> shared = objects[0];
+    auto atomicLoadTime = runReaders(readerCount, iterations, [&] {
+        auto c = std::atomic_load(&shared);
+        return c ? c->value : 0;
+    }, [&] (int i) {
+        std::atomic_store(&shared, objects[i % objects.size()]);
+    });
+
+    PublishedPtr<Counted> published;
+    published.set(objects[0]);
+    auto publishedTime = runReaders(readerCount, iterations, [&] {
+        auto c = published.get();
+        return c ? c->value : 0;
+    }, [&] (int i) {
+        published.set(objects[i % objects.size()]);
+    });
+
+    auto reads = double(readerCount * iterations);
+    std::cout << readerCount << " readers, " << iterations << " reads each:" << std::endl
+              << "    std::atomic_load(shared_ptr): " << duration<double, std::nano>(atomicLoadTime).count() / reads << " ns/read" << std::endl
+              << "    PublishedPtr::get():          " << duration<double, std::nano>(publishedTime).count() / reads << " ns/read" << std::endl;
+}
+
+} // namespace
+} // riner
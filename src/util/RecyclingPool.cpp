@@ -0,0 +1,97 @@
+//
+//
+
+#include "RecyclingPool.h"
+
+namespace riner {
+
+    namespace {
+        struct PoolList {
+            std::mutex mutex;
+            std::vector<const RecyclingPoolBase *> pools;
+        };
+
+        PoolList &poolList() {
+            static PoolList *list = new PoolList(); //leaked on purpose, like the pools themselves
+            return *list;
+        }
+    }
+
+    RecyclingPoolBase::RecyclingPoolBase(std::string name, size_t objectSize)
+            : _name(std::move(name))
+            , _objectSize(objectSize) {
+        auto &list = poolList();
+        std::lock_guard<std::mutex> lock(list.mutex);
+        list.pools.push_back(this);
+    }
+
+    std::vector<RecyclingPoolStats> RecyclingPoolBase::getAllStats() {
+        auto &list = poolList();
+        std::lock_guard<std::mutex> lock(list.mutex);
+
+        std::vector<RecyclingPoolStats> result;
+        result.reserve(list.pools.size());
+        for (auto pool : list.pools) {
+            result.push_back(pool->getStats());
+        }
+        return result;
+    }
+
+    RecyclingPoolStats RecyclingPoolBase::getStats() const {
+        RecyclingPoolStats stats;
+        stats.name = _name;
+        stats.objectSize = _objectSize;
+        stats.allocations = _allocations.load(std::memory_order_relaxed);
+        stats.heapAllocations = _heapAllocations.load(std::memory_order_relaxed);
+        stats.heapFrees = _heapFrees.load(std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            stats.sharedFreeListSize = _sharedCount;
+        }
+        return stats;
+    }
+
+    size_t RecyclingPoolBase::takeBatch(Node *&head) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        size_t count = 0;
+        head = nullptr;
+
+        while (_sharedHead && count < batchSize) {
+            Node *node = _sharedHead;
+            _sharedHead = node->next;
+            node->next = head;
+            head = node;
+            ++count;
+        }
+        _sharedCount -= count;
+        return count;
+    }
+
+    void RecyclingPoolBase::giveBatch(Node *head, size_t count) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            while (head && _sharedCount < maxSharedFreeListSize) {
+                Node *node = head;
+                head = node->next;
+                node->next = _sharedHead;
+                _sharedHead = node;
+                ++_sharedCount;
+                --count;
+            }
+        }
+
+        //shared free list is full, return the rest to the heap
+        _heapFrees.fetch_add(count, std::memory_order_relaxed);
+        while (head) {
+            Node *node = head;
+            head = node->next;
+            ::operator delete(node);
+        }
+    }
+
+    void *RecyclingPoolBase::heapAllocate() {
+        _heapAllocations.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(_objectSize);
+    }
+
+}
@@ -0,0 +1,191 @@
+//
+//
+
+#pragma once
+
+#include <src/util/Copy.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <new>
+#include <cstddef>
+
+namespace riner {
+
+    /**
+     * @brief snapshot of the statistics of one RecyclingPool
+     */
+    struct RecyclingPoolStats {
+        std::string name;
+        size_t objectSize = 0;
+        uint64_t allocations = 0; //total amount of objects handed out
+        uint64_t heapAllocations = 0; //allocations that could not be served from a free list
+        uint64_t heapFrees = 0; //objects given back to the heap because the shared free list was full
+        size_t sharedFreeListSize = 0; //objects currently kept in the shared free list (thread caches are not included)
+    };
+
+    /**
+     * @brief type independent part of RecyclingPool<T>: the shared free list and the statistics
+     * every RecyclingPoolBase registers itself, so that all pools' statistics can be queried via getAllStats()
+     */
+    class RecyclingPoolBase {
+    public:
+        /**
+         * free objects are linked through their own memory
+         */
+        struct Node {
+            Node *next;
+        };
+
+        /**
+         * @return statistics of all RecyclingPools that were used so far
+         */
+        static std::vector<RecyclingPoolStats> getAllStats();
+
+        RecyclingPoolStats getStats() const;
+
+        DELETE_COPY_AND_MOVE(RecyclingPoolBase);
+
+    protected:
+        RecyclingPoolBase(std::string name, size_t objectSize);
+        ~RecyclingPoolBase() = default;
+
+        static constexpr size_t batchSize = 32; //amount of objects moved between a thread cache and the shared free list at once
+        static constexpr size_t maxSharedFreeListSize = 4096; //objects beyond that are returned to the heap
+
+        /**
+         * moves up to batchSize objects from the shared free list into a thread cache
+         * @return amount of objects moved
+         */
+        size_t takeBatch(Node *&head);
+
+        /**
+         * moves count objects from a thread cache into the shared free list, or back to the heap if the list is full
+         */
+        void giveBatch(Node *head, size_t count);
+
+        void *heapAllocate();
+
+        const std::string _name;
+        const size_t _objectSize;
+
+        std::atomic<uint64_t> _allocations {0};
+        std::atomic<uint64_t> _heapAllocations {0};
+        std::atomic<uint64_t> _heapFrees {0};
+
+    private:
+        mutable std::mutex _mutex;
+        Node *_sharedHead = nullptr;
+        size_t _sharedCount = 0;
+    };
+
+    /**
+     * @brief free-list allocator for objects of type T
+     * Every thread keeps a small cache of free objects, so that allocating and freeing usually doesn't take a lock.
+     * Threads that mostly free objects (e.g. algorithm threads freeing Work made by a refill thread) hand their
+     * surplus over to a shared free list in batches, where allocating threads pick them up again.
+     * Use it via the Recyclable<T> base class rather than directly.
+     * @tparam T must provide a `static std::string recyclingPoolName()`
+     */
+    template<class T>
+    class RecyclingPool : public RecyclingPoolBase {
+
+        static constexpr size_t maxThreadCacheSize = 2 * batchSize;
+
+        struct ThreadCache {
+            Node *head = nullptr;
+            size_t count = 0;
+
+            ~ThreadCache() {
+                if (head) {
+                    instance().giveBatch(head, count);
+                }
+            }
+        };
+
+        static ThreadCache &threadCache() {
+            static thread_local ThreadCache cache;
+            return cache;
+        }
+
+        RecyclingPool()
+                : RecyclingPoolBase(T::recyclingPoolName(), sizeof(T)) {
+        }
+
+    public:
+        static_assert(sizeof(T) >= sizeof(Node), "");
+
+        static RecyclingPool &instance() {
+            //intentionally leaked, so that threads exiting after static destruction can still return their cache
+            static RecyclingPool *pool = new RecyclingPool();
+            return *pool;
+        }
+
+        void *allocate() {
+            _allocations.fetch_add(1, std::memory_order_relaxed);
+            ThreadCache &cache = threadCache();
+
+            if (!cache.head) {
+                cache.count = takeBatch(cache.head);
+                if (!cache.head) {
+                    return heapAllocate();
+                }
+            }
+
+            Node *node = cache.head;
+            cache.head = node->next;
+            --cache.count;
+            return node;
+        }
+
+        void deallocate(void *ptr) {
+            ThreadCache &cache = threadCache();
+
+            auto node = static_cast<Node *>(ptr);
+            node->next = cache.head;
+            cache.head = node;
+            ++cache.count;
+
+            if (cache.count > maxThreadCacheSize) {
+                //detach batchSize nodes and give them to the shared free list
+                Node *batchHead = cache.head;
+                Node *batchTail = batchHead;
+                for (size_t i = 1; i < batchSize; ++i) {
+                    batchTail = batchTail->next;
+                }
+                cache.head = batchTail->next;
+                cache.count -= batchSize;
+                batchTail->next = nullptr;
+                giveBatch(batchHead, batchSize);
+            }
+        }
+    };
+
+    /**
+     * @brief inherit from Recyclable<T> to make `new T`/`delete` (and therefore make_unique<T>) use a RecyclingPool<T>
+     * deleting a T through a base class pointer works as long as the base class has a virtual destructor.
+     * Objects of classes derived from T have a different size and fall back to the global operator new.
+     * @tparam T the class that inherits from Recyclable<T>, see RecyclingPool for its requirements
+     */
+    template<class T>
+    class Recyclable {
+    public:
+        static void *operator new(size_t size) {
+            if (size != sizeof(T))
+                return ::operator new(size);
+            return RecyclingPool<T>::instance().allocate();
+        }
+
+        static void operator delete(void *ptr, size_t size) {
+            if (!ptr)
+                return;
+            if (size != sizeof(T)) {
+                ::operator delete(ptr);
+                return;
+            }
+            RecyclingPool<T>::instance().deallocate(ptr);
+        }
+    };
+
+}